@@ -8,6 +8,9 @@ create database if not exists rainhub_db
 
 use rainhub_db;
 
+-- users 与 record 互相引用（open_record_id → record），建表期间先关闭外键检查
+set foreign_key_checks = 0;
+
 -- 用户表
 -- role: 0=学生, 1=教职工, 9=管理员
 -- is_active: 0=未激活(首次登录需设置密码), 1=已激活
@@ -18,8 +21,11 @@ create table if not exists users (
     role int not null default 0,
     credit decimal(10, 2) not null default 0.00,
     is_active tinyint(1) not null default 0,
+    open_record_id bigint null, -- 未归还订单的 record_id，借伞时写入、还伞时清空；不为 null 时不能再借
     primary key (user_id),
-    index idx_role (role)
+    index idx_role (role),
+    index idx_real_name (real_name), -- 管理员后台按姓名前缀搜索
+    constraint fk_users_open_record foreign key (open_record_id) references record(record_id) on delete set null
 ) engine=innodb default charset=utf8mb4;
 
 -- 站点表
@@ -33,13 +39,14 @@ create table if not exists station (
     pos_y float not null,
     status int not null default 1,
     unavailable_slots varchar(50) not null default '',
+    version int not null default 0, -- 行版本号，每次修改 +1，条件更新防止互相覆盖
     primary key (station_id)
 ) engine=innodb default charset=utf8mb4;
 
 -- 雨具表
 -- type_id: 1=普通塑料伞, 2=高质量抗风伞, 3=专用遮阳伞, 4=雨衣
 -- status: 0=Unknown, 1=Available可用, 2=Borrowed借出, 3=Broken损坏
--- slot_id: 1-12 对应每个站点的12个槽位
+-- slot_id: 1-12 对应每个站点的12个槽位，借出中为 null
 -- 槽位分配规则: 1-4普通塑料伞, 5-8高质量抗风伞, 9-10遮阳伞, 11-12雨衣
 create table if not exists raingear (
     gear_id varchar(20) not null,
@@ -47,26 +54,59 @@ create table if not exists raingear (
     station_id int null,
     slot_id int null,
     status int not null default 1,
+    version int not null default 0, -- 行版本号，每次修改 +1，条件更新防止互相覆盖
     primary key (gear_id),
-    index idx_station (station_id),
+    index idx_station_status (station_id, status), -- 覆盖按站点、状态的统计
+    unique index uk_station_slot (station_id, slot_id), -- 一个槽位最多一把雨具，借出中的雨具 slot_id 为 null
     index idx_status (status),
     foreign key (station_id) references station(station_id) on delete set null on update cascade
 ) engine=innodb default charset=utf8mb4;
 
 -- 借还记录表
 -- return_time 为 null 表示未归还
+-- station_id 为借出站点，订单流水按站点筛选用
+-- 订单流水按 (borrow_time, record_id) 倒序分页，各筛选条件的索引都以 borrow_time 为第二列
 create table if not exists record (
     record_id bigint not null auto_increment,
     user_id varchar(20) not null,
     gear_id varchar(20) not null,
+    station_id int null,
     borrow_time datetime not null,
     return_time datetime null,
     cost decimal(10, 2) not null default 0.00,
     primary key (record_id),
-    index idx_user (user_id),
-    index idx_gear (gear_id),
+    index idx_user_time (user_id, borrow_time),
+    index idx_gear_time (gear_id, borrow_time),
+    index idx_station_time (station_id, borrow_time),
+    index idx_borrow_time (borrow_time, record_id),
+    index idx_return_time (return_time, borrow_time),
+    index idx_user_return (user_id, return_time), -- 查询用户未归还的订单
     foreign key (user_id) references users(user_id) on delete restrict on update cascade,
     foreign key (gear_id) references raingear(gear_id) on delete restrict on update cascade
 ) engine=innodb default charset=utf8mb4;
 
+set foreign_key_checks = 1;
+
+-- 借还请求去重表
+-- request_id 由终端生成，成功的借还请求在同一事务里写入；终端超时重试同一请求时直接返回这里记录的结果
+-- kind: 1=借伞, 2=还伞；超过保留期（24 小时）的记录由程序定期清理
+create table if not exists request_log (
+    request_id varchar(64) not null,
+    user_id varchar(20) not null,
+    kind int not null,
+    message varchar(200) not null,
+    cost decimal(10, 2) not null default 0.00,
+    created_at datetime not null,
+    primary key (request_id),
+    index idx_created_at (created_at)
+) engine=innodb default charset=utf8mb4;
+
+-- 结构版本表，由程序中的 SchemaMigrator 维护；本脚本建出的已是最新结构，首次启动时各迁移步骤检查后直接记为已执行
+create table if not exists schema_version (
+    version int not null,
+    description varchar(100) not null,
+    applied_at datetime not null,
+    primary key (version)
+) engine=innodb default charset=utf8mb4;
+
 select 'init_db.sql executed successfully!' as message;
@@ -18,12 +18,14 @@ public:
     GearStatus get_status() const { return status; }
     Station get_station_id() const { return station_id; }
     int get_slot_id() const { return slot_id; }
+    int get_version() const { return version; } // 行版本号，条件更新时使用
     bool is_available() const { return status == GearStatus::Available; }  // 唯一可借状态
 
     // setters
     void set_status(GearStatus s) { this->status = s; }
     void set_station_id(Station station_id) { this->station_id = station_id; }
     void set_slot_id(int slot_id) { this->slot_id = slot_id; }
+    void set_version(int version) { this->version = version; }
 
     // 纯虚接口：不同品类押金与图标不同。
     virtual double get_deposit() const = 0; // 获取押金金额
@@ -34,4 +36,5 @@ private:
     GearStatus status; // 状态
     Station station_id=Station::Unknown;
     int slot_id=0; // 槽位
+    int version=0; // 读取时的行版本号
 };
@@ -22,3 +22,13 @@ QString StationUtils::getChineseName(Station station) {
         default:                  return QStringLiteral("未知站点");
     }
 }
+
+bool StationUtils::isSlotForType(GearType type, int slotId) {
+    switch (type) {
+        case GearType::StandardPlastic:   return slotId >= 1 && slotId <= 4;
+        case GearType::PremiumWindproof:  return slotId >= 5 && slotId <= 8;
+        case GearType::Sunshade:          return slotId >= 9 && slotId <= 10;
+        case GearType::Raincoat:          return slotId >= 11 && slotId <= 12;
+        default:                          return false;
+    }
+}
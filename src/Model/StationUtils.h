@@ -1,5 +1,5 @@
 /*
-    为站点枚举提供中文名称映射的工具类
+    为站点枚举提供中文名称映射、槽位规则等的工具类
 */
 #pragma once
 
@@ -10,5 +10,7 @@ class StationUtils {
 public:
     //输入站点枚举，返回中文名称
     static QString getChineseName(Station station);
+    //槽位是否可以放该类型的雨具：1-4普通塑料伞，5-8高质量抗风伞，9-10专用遮阳伞，11-12雨衣
+    static bool isSlotForType(GearType type, int slotId);
 };
 
@@ -9,6 +9,7 @@
 #include "../control/Admin_UserService.h"
 #include "../control/Admin_OrderService.h"
 #include "../Model/User.h"
+#include "../utils/DbHealthMonitor.h"
 
 #include <QApplication>
 #include <QComboBox>
@@ -29,6 +30,8 @@
 #include <QBrush>
 #include <QColor>
 #include <QAbstractItemView>
+#include <QSignalBlocker>
+#include <QFileDialog>
 
 AdminMainWindow::AdminMainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -47,9 +50,19 @@ AdminMainWindow::AdminMainWindow(QWidget *parent)
     
     m_refreshTimer = new QTimer(this);
     connect(m_refreshTimer, &QTimer::timeout, this, &AdminMainWindow::onRefreshTimer);
+
+    auto *monitor = DbHealthMonitor::instance();
+    connect(monitor, &DbHealthMonitor::stateChanged, this, &AdminMainWindow::onDbHealthChanged);
+    onDbHealthChanged(monitor->state());
+    monitor->start();
 }
 
-AdminMainWindow::~AdminMainWindow() = default;
+AdminMainWindow::~AdminMainWindow()
+{
+    // 等待DB工作线程上的任务结束，它们还在使用本窗口持有的Service；正在进行的导出直接中止
+    m_orderExportToken.cancel();
+    DbExecutor::waitForDone();
+}
 
 void AdminMainWindow::setupUi()
 {
@@ -59,6 +72,11 @@ void AdminMainWindow::setupUi()
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(0);
 
+    m_dbStatusBanner = new QLabel(central);
+    m_dbStatusBanner->setAlignment(Qt::AlignCenter);
+    m_dbStatusBanner->hide();
+    layout->addWidget(m_dbStatusBanner);
+
     m_stack = new QStackedWidget(this);
     m_stack->addWidget(createLoginPage());
     m_stack->addWidget(createDashboardPage());
@@ -125,7 +143,7 @@ QWidget* AdminMainWindow::createLoginPage()
     btnLogin->setStyleSheet(Styles::Buttons::primary());
     btnLogin->setCursor(Qt::PointingHandCursor);
     
-    connect(btnLogin, &QPushButton::clicked, this, [this] {
+    connect(btnLogin, &QPushButton::clicked, this, [this, btnLogin] {
         const QString userId = m_loginUserIdInput->text().trimmed();
         const QString password = m_loginPasswordInput->text();
 
@@ -134,30 +152,34 @@ QWidget* AdminMainWindow::createLoginPage()
             return;
         }
 
-        auto adminOpt = m_authService->adminLogin(userId, password);
-        if (!adminOpt) {
-            QMessageBox::warning(this, tr("登录失败"), tr("账号或密码错误，或该账号不是管理员"));
-            return;
-        }
+        // 验证在DB工作线程执行，期间禁用登录按钮防止重复提交
+        btnLogin->setEnabled(false);
+        m_authService->adminLoginAsync(userId, password, this, [this, btnLogin](std::optional<User> adminOpt) {
+            btnLogin->setEnabled(true);
+            if (!adminOpt) {
+                QMessageBox::warning(this, tr("登录失败"), tr("账号或密码错误，或该账号不是管理员"));
+                return;
+            }
         
-        m_currentAdmin = std::make_shared<User>(
-            adminOpt->get_id(),
-            adminOpt->get_name(),
-            adminOpt->get_password(),
-            adminOpt->get_role(),
-            adminOpt->get_credit(),
-            adminOpt->get_is_active()
-        );
+            m_currentAdmin = std::make_shared<User>(
+                adminOpt->get_id(),
+                adminOpt->get_name(),
+                adminOpt->get_password(),
+                adminOpt->get_role(),
+                adminOpt->get_credit(),
+                adminOpt->get_is_active()
+            );
         
-        m_loginPasswordInput->clear();
+            m_loginPasswordInput->clear();
         
-        if (m_adminLabel) {
-            m_adminLabel->setText(tr("👤 管理员：%1").arg(m_currentAdmin->get_name()));
-        }
+            if (m_adminLabel) {
+                m_adminLabel->setText(tr("👤 管理员：%1").arg(m_currentAdmin->get_name()));
+            }
         
-        QMessageBox::information(this, tr("登录成功"), tr("欢迎，%1").arg(m_currentAdmin->get_name()));
-        switchPage(Page::Dashboard);
-        m_refreshTimer->start(5000);
+            QMessageBox::information(this, tr("登录成功"), tr("欢迎，%1").arg(m_currentAdmin->get_name()));
+            switchPage(Page::Dashboard);
+            m_refreshTimer->start(5000);
+        });
     });
 
     cardLayout->addWidget(iconLabel, 0, Qt::AlignCenter);
@@ -391,7 +413,10 @@ QWidget* AdminMainWindow::createGearManagePage()
     auto *btnRefresh = new QPushButton(tr("刷新"), filterCard);
     btnRefresh->setStyleSheet(Styles::Buttons::secondary());
     btnRefresh->setCursor(Qt::PointingHandCursor);
-    connect(btnRefresh, &QPushButton::clicked, this, &AdminMainWindow::refreshGearManageData);
+    connect(btnRefresh, &QPushButton::clicked, this, [this]() {
+        m_gearForceCount = true;
+        refreshGearManageData();
+    });
     connect(m_gearStationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
             this, &AdminMainWindow::refreshGearManageData);
     connect(m_gearSlotCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
@@ -403,7 +428,44 @@ QWidget* AdminMainWindow::createGearManagePage()
     filterLayout->addWidget(slotLabel);
     filterLayout->addWidget(m_gearSlotCombo);
     filterLayout->addSpacing(16);
+    // 批量入库：从文件读取雨具清单，在DB工作线程写入，完成后汇报结果
+    auto *btnProvision = new QPushButton(tr("批量入库"), filterCard);
+    btnProvision->setStyleSheet(Styles::Buttons::secondary());
+    btnProvision->setCursor(Qt::PointingHandCursor);
+    connect(btnProvision, &QPushButton::clicked, this, [this, btnProvision]() {
+        QString path = QFileDialog::getOpenFileName(this, tr("选择雨具清单"), QString(),
+                                                    tr("CSV 文件 (*.csv *.txt)"));
+        if (path.isEmpty()) return;
+        
+        QStringList parseErrors;
+        auto gears = Admin_GearService::parseProvisionCsv(path, &parseErrors);
+        if (gears.isEmpty()) {
+            QMessageBox::warning(this, tr("批量入库"), tr("文件中没有可导入的雨具\n%1").arg(parseErrors.join("\n")));
+            return;
+        }
+        
+        btnProvision->setEnabled(false);
+        m_gearService->provisionGearsAsync(gears, this, [this, btnProvision, parseErrors](ProvisionReport report) {
+            btnProvision->setEnabled(true);
+            QStringList problems = parseErrors + report.errors;
+            QString text = tr("提交 %1 条，成功写入 %2 条，校验跳过 %3 条，写入失败 %4 条\n耗时 %5 ms（约 %6 条/秒）")
+                .arg(report.requested).arg(report.inserted).arg(report.rejected).arg(report.failed)
+                .arg(report.elapsedMs).arg(qRound(report.rowsPerSecond()));
+            if (!problems.isEmpty()) {
+                text += "\n\n" + problems.mid(0, ProvisionReport::MAX_ERRORS).join("\n");
+            }
+            if (report.failed > 0 || report.rejected > 0 || !parseErrors.isEmpty()) {
+                QMessageBox::warning(this, tr("批量入库"), text);
+            } else {
+                QMessageBox::information(this, tr("批量入库"), text);
+            }
+            m_gearForceCount = true;
+            refreshGearManageData();
+        });
+    });
+    
     filterLayout->addWidget(btnRefresh);
+    filterLayout->addWidget(btnProvision);
     filterLayout->addStretch();
 
     // 雨具表格
@@ -431,8 +493,10 @@ QWidget* AdminMainWindow::createGearManagePage()
     m_gearPrevBtn->setCursor(Qt::PointingHandCursor);
     m_gearPrevBtn->setEnabled(false);
     connect(m_gearPrevBtn, &QPushButton::clicked, this, [this]() {
-        if (m_gearCurrentPage > 1) {
-            m_gearCurrentPage--;
+        if (!m_gearFirstId.isEmpty()) {
+            m_gearCurrentPage = qMax(1, m_gearCurrentPage - 1);
+            m_gearCursor = m_gearFirstId;
+            m_gearDirection = PageDirection::Before;
             refreshGearManageData();
         }
     });
@@ -442,6 +506,8 @@ QWidget* AdminMainWindow::createGearManagePage()
     m_gearNextBtn->setCursor(Qt::PointingHandCursor);
     connect(m_gearNextBtn, &QPushButton::clicked, this, [this]() {
         m_gearCurrentPage++;
+        m_gearCursor = m_gearLastId;
+        m_gearDirection = PageDirection::After;
         refreshGearManageData();
     });
     
@@ -503,8 +569,13 @@ QWidget* AdminMainWindow::createUserManagePage()
     auto *btnSearch = new QPushButton(tr("搜索"), searchCard);
     btnSearch->setStyleSheet(Styles::Buttons::secondary());
     btnSearch->setCursor(Qt::PointingHandCursor);
-    connect(btnSearch, &QPushButton::clicked, this, &AdminMainWindow::refreshUserManageData);
-    connect(m_userSearchInput, &QLineEdit::returnPressed, this, &AdminMainWindow::refreshUserManageData);
+    // 新的搜索从第一页开始
+    auto startSearch = [this]() {
+        m_userCurrentPage = 1;
+        refreshUserManageData();
+    };
+    connect(btnSearch, &QPushButton::clicked, this, startSearch);
+    connect(m_userSearchInput, &QLineEdit::returnPressed, this, startSearch);
     
     searchLayout->addWidget(m_userSearchInput);
     searchLayout->addWidget(btnSearch);
@@ -521,9 +592,44 @@ QWidget* AdminMainWindow::createUserManagePage()
     m_userTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_userTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
+    // 分页控件
+    auto *paginationCard = new QWidget(contentArea);
+    paginationCard->setStyleSheet(Styles::statCard());
+    auto *paginationLayout = new QHBoxLayout(paginationCard);
+    paginationLayout->setContentsMargins(20, 12, 20, 12);
+    
+    m_userPageInfo = new QLabel(tr("第 1 页，共 1 页"), paginationCard);
+    m_userPageInfo->setStyleSheet(Styles::Labels::hint());
+    
+    m_userPrevBtn = new QPushButton(tr("上一页"), paginationCard);
+    m_userPrevBtn->setStyleSheet(Styles::Buttons::secondary());
+    m_userPrevBtn->setCursor(Qt::PointingHandCursor);
+    m_userPrevBtn->setEnabled(false);
+    connect(m_userPrevBtn, &QPushButton::clicked, this, [this]() {
+        if (m_userCurrentPage > 1) {
+            m_userCurrentPage--;
+            refreshUserManageData();
+        }
+    });
+    
+    m_userNextBtn = new QPushButton(tr("下一页"), paginationCard);
+    m_userNextBtn->setStyleSheet(Styles::Buttons::secondary());
+    m_userNextBtn->setCursor(Qt::PointingHandCursor);
+    connect(m_userNextBtn, &QPushButton::clicked, this, [this]() {
+        m_userCurrentPage++;
+        refreshUserManageData();
+    });
+    
+    paginationLayout->addWidget(m_userPageInfo);
+    paginationLayout->addStretch();
+    paginationLayout->addWidget(m_userPrevBtn);
+    paginationLayout->addSpacing(8);
+    paginationLayout->addWidget(m_userNextBtn);
+
     contentLayout->addWidget(title);
     contentLayout->addWidget(searchCard);
     contentLayout->addWidget(m_userTable, 1);
+    contentLayout->addWidget(paginationCard);
 
     mainLayout->addWidget(sidebar);
     mainLayout->addWidget(contentArea, 1);
@@ -559,19 +665,144 @@ QWidget* AdminMainWindow::createOrderManagePage()
     auto *title = new QLabel(tr("📋 订单流水"), contentArea);
     title->setStyleSheet(Styles::Labels::pageTitle());
 
+    // 筛选区域
+    auto *filterCard = new QWidget(contentArea);
+    filterCard->setStyleSheet(Styles::statCard());
+    auto *filterLayout = new QHBoxLayout(filterCard);
+    filterLayout->setContentsMargins(20, 16, 20, 16);
+    
+    m_orderUserInput = new QLineEdit(filterCard);
+    m_orderUserInput->setPlaceholderText(tr("学号/工号"));
+    m_orderUserInput->setFixedWidth(140);
+    m_orderGearInput = new QLineEdit(filterCard);
+    m_orderGearInput->setPlaceholderText(tr("雨具ID"));
+    m_orderGearInput->setFixedWidth(140);
+    
+    m_orderStationCombo = new QComboBox(filterCard);
+    m_orderStationCombo->addItem(tr("全部站点"), 0);
+    m_orderStationCombo->setFixedWidth(140);
+    
+    m_orderStatusCombo = new QComboBox(filterCard);
+    m_orderStatusCombo->addItem(tr("全部状态"), static_cast<int>(OrderStatus::All));
+    m_orderStatusCombo->addItem(tr("未归还"), static_cast<int>(OrderStatus::Open));
+    m_orderStatusCombo->addItem(tr("已归还"), static_cast<int>(OrderStatus::Closed));
+    m_orderStatusCombo->setFixedWidth(110);
+    
+    m_orderRangeCombo = new QComboBox(filterCard);
+    m_orderRangeCombo->addItem(tr("全部时间"), 0);
+    m_orderRangeCombo->addItem(tr("今天"), 1);
+    m_orderRangeCombo->addItem(tr("最近7天"), 7);
+    m_orderRangeCombo->addItem(tr("最近30天"), 30);
+    m_orderRangeCombo->setFixedWidth(110);
+    
+    auto *btnQuery = new QPushButton(tr("查询"), filterCard);
+    btnQuery->setStyleSheet(Styles::Buttons::secondary());
+    btnQuery->setCursor(Qt::PointingHandCursor);
+    connect(btnQuery, &QPushButton::clicked, this, &AdminMainWindow::resetOrderPaging);
+    connect(m_orderUserInput, &QLineEdit::returnPressed, this, &AdminMainWindow::resetOrderPaging);
+    connect(m_orderGearInput, &QLineEdit::returnPressed, this, &AdminMainWindow::resetOrderPaging);
+    connect(m_orderStationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
+            this, &AdminMainWindow::resetOrderPaging);
+    connect(m_orderStatusCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
+            this, &AdminMainWindow::resetOrderPaging);
+    connect(m_orderRangeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
+            this, &AdminMainWindow::resetOrderPaging);
+    
+    filterLayout->addWidget(m_orderUserInput);
+    filterLayout->addWidget(m_orderGearInput);
+    filterLayout->addWidget(m_orderStationCombo);
+    filterLayout->addWidget(m_orderStatusCombo);
+    // 导出：按当前筛选条件把全部订单流式写入 CSV，导出过程中按钮变为取消
+    auto *btnExport = new QPushButton(tr("导出"), filterCard);
+    btnExport->setStyleSheet(Styles::Buttons::secondary());
+    btnExport->setCursor(Qt::PointingHandCursor);
+    connect(btnExport, &QPushButton::clicked, this, [this, btnExport]() {
+        if (m_orderExporting) {
+            m_orderExportToken.cancel();
+            btnExport->setEnabled(false);
+            return;
+        }
+        QString path = QFileDialog::getSaveFileName(this, tr("导出订单"),
+                                                    QStringLiteral("orders_%1.csv").arg(QDate::currentDate().toString("yyyyMMdd")),
+                                                    tr("CSV 文件 (*.csv)"));
+        if (path.isEmpty()) return;
+        
+        m_orderExporting = true;
+        m_orderExportToken = CancelToken();
+        btnExport->setText(tr("取消导出"));
+        m_orderService->exportOrdersAsync(currentOrderFilter(), path, this, [this, btnExport](OrderExportResult result) {
+            m_orderExporting = false;
+            btnExport->setText(tr("导出"));
+            btnExport->setEnabled(true);
+            if (result.ok) {
+                QMessageBox::information(this, tr("导出订单"), tr("已导出 %1 条订单").arg(result.rows));
+            } else if (result.cancelled) {
+                QMessageBox::information(this, tr("导出订单"), tr("导出已取消"));
+            } else {
+                QMessageBox::warning(this, tr("导出订单"), tr("导出失败：%1").arg(result.error));
+            }
+        }, m_orderExportToken);
+    });
+    
+    filterLayout->addWidget(m_orderRangeCombo);
+    filterLayout->addWidget(btnQuery);
+    filterLayout->addWidget(btnExport);
+    filterLayout->addStretch();
+
     m_orderTable = new QTableWidget(contentArea);
-    m_orderTable->setColumnCount(6);
+    m_orderTable->setColumnCount(7);
     m_orderTable->setHorizontalHeaderLabels({
-        tr("流水号"), tr("用户"), tr("雨具ID"), tr("借出时间"), tr("归还时间"), tr("费用")
+        tr("流水号"), tr("用户"), tr("雨具ID"), tr("借出站点"), tr("借出时间"), tr("归还时间"), tr("费用")
     });
     m_orderTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-    m_orderTable->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
     m_orderTable->horizontalHeader()->setSectionResizeMode(4, QHeaderView::Stretch);
+    m_orderTable->horizontalHeader()->setSectionResizeMode(5, QHeaderView::Stretch);
     m_orderTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_orderTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
+    // 分页控件
+    auto *paginationCard = new QWidget(contentArea);
+    paginationCard->setStyleSheet(Styles::statCard());
+    auto *paginationLayout = new QHBoxLayout(paginationCard);
+    paginationLayout->setContentsMargins(20, 12, 20, 12);
+    
+    m_orderPageInfo = new QLabel(tr("第 1 页"), paginationCard);
+    m_orderPageInfo->setStyleSheet(Styles::Labels::hint());
+    
+    m_orderPrevBtn = new QPushButton(tr("上一页"), paginationCard);
+    m_orderPrevBtn->setStyleSheet(Styles::Buttons::secondary());
+    m_orderPrevBtn->setCursor(Qt::PointingHandCursor);
+    m_orderPrevBtn->setEnabled(false);
+    connect(m_orderPrevBtn, &QPushButton::clicked, this, [this]() {
+        if (!m_orderFirst.isNull()) {
+            m_orderCurrentPage = qMax(1, m_orderCurrentPage - 1);
+            m_orderCursor = m_orderFirst;
+            m_orderDirection = PageDirection::Before;
+            refreshOrderManageData();
+        }
+    });
+    
+    m_orderNextBtn = new QPushButton(tr("下一页"), paginationCard);
+    m_orderNextBtn->setStyleSheet(Styles::Buttons::secondary());
+    m_orderNextBtn->setCursor(Qt::PointingHandCursor);
+    m_orderNextBtn->setEnabled(false);
+    connect(m_orderNextBtn, &QPushButton::clicked, this, [this]() {
+        m_orderCurrentPage++;
+        m_orderCursor = m_orderLast;
+        m_orderDirection = PageDirection::After;
+        refreshOrderManageData();
+    });
+    
+    paginationLayout->addWidget(m_orderPageInfo);
+    paginationLayout->addStretch();
+    paginationLayout->addWidget(m_orderPrevBtn);
+    paginationLayout->addSpacing(8);
+    paginationLayout->addWidget(m_orderNextBtn);
+
     contentLayout->addWidget(title);
+    contentLayout->addWidget(filterCard);
     contentLayout->addWidget(m_orderTable, 1);
+    contentLayout->addWidget(paginationCard);
 
     mainLayout->addWidget(sidebar);
     mainLayout->addWidget(contentArea, 1);
@@ -613,6 +844,34 @@ void AdminMainWindow::handleLogout()
     switchPage(Page::Login);
 }
 
+void AdminMainWindow::onDbHealthChanged(DbHealth state)
+{
+    if (state == DbHealth::Healthy) {
+        m_dbStatusBanner->hide();
+        if (m_refreshPausedByDb) {
+            m_refreshPausedByDb = false;
+            if (m_currentAdmin) {
+                m_refreshTimer->start();
+                onRefreshTimer(); // 恢复后立即刷新一次当前页面
+            }
+        }
+        return;
+    }
+
+    if (state == DbHealth::Degraded) {
+        m_dbStatusBanner->setText(tr("数据库连接不稳定，数据可能刷新较慢"));
+        m_dbStatusBanner->setStyleSheet("font-size:13px; color:#8a5a00; background-color:#fff4d6; padding:6px;");
+    } else {
+        m_dbStatusBanner->setText(tr("数据库连接中断，页面数据暂停刷新，正在后台自动重连…"));
+        m_dbStatusBanner->setStyleSheet("font-size:13px; color:#ffffff; background-color:#d9534f; padding:6px;");
+        if (m_refreshTimer && m_refreshTimer->isActive()) {
+            m_refreshTimer->stop();
+            m_refreshPausedByDb = true;
+        }
+    }
+    m_dbStatusBanner->show();
+}
+
 void AdminMainWindow::onRefreshTimer()
 {
     int currentPage = m_stack->currentIndex();
@@ -640,105 +899,132 @@ void AdminMainWindow::refreshDashboardData()
         m_weatherLabel->setText(getWeatherInfo());
     }
     
-    // 获取统计数据
-    double onlineRate = m_stationService->getOnlineRate();
-    int borrowedCount = m_gearService->getTotalBorrowedCount();
-    int brokenCount = m_gearService->getTotalBrokenCount();
+    // 统计卡片和站点表格的查询都在DB工作线程执行，返回后再填充；上一轮还没返回的请求直接作废
+    m_dashboardToken.cancel();
+    m_dashboardToken = CancelToken();
+
+    struct Counters {
+        double onlineRate = 0.0;
+        int borrowedCount = 0;
+        int brokenCount = 0;
+    };
+    Admin_StationService *stationService = m_stationService.get();
+    Admin_GearService *gearService = m_gearService.get();
+    DbExecutor::submit(this, [stationService, gearService]() {
+        Counters counters;
+        counters.onlineRate = stationService->getOnlineRate();
+        counters.borrowedCount = gearService->getTotalBorrowedCount();
+        counters.brokenCount = gearService->getTotalBrokenCount();
+        return counters;
+    }, [this](Counters counters) {
+        if (m_onlineDevicesLabel) {
+            m_onlineDevicesLabel->setText(QString("%1%").arg(QString::number(counters.onlineRate, 'f', 0)));
+        }
+        if (m_borrowedGearsLabel) {
+            m_borrowedGearsLabel->setText(QString("%1 把").arg(counters.borrowedCount));
+        }
+        if (m_faultCountLabel) {
+            m_faultCountLabel->setText(QString::number(counters.brokenCount));
+        }
+    }, m_dashboardToken);
     
-    if (m_onlineDevicesLabel) {
-        m_onlineDevicesLabel->setText(QString("%1%").arg(QString::number(onlineRate, 'f', 0)));
-    }
-    if (m_borrowedGearsLabel) {
-        m_borrowedGearsLabel->setText(QString("%1 把").arg(borrowedCount));
-    }
-    if (m_faultCountLabel) {
-        m_faultCountLabel->setText(QString::number(brokenCount));
+    if (m_stationTable) {
+        m_stationService->getStationStatsAsync(this, [this](QVector<StationStats> stationStats) {
+            populateStationTable(stationStats);
+        }, m_dashboardToken);
     }
+}
+
+void AdminMainWindow::populateStationTable(const QVector<StationStatsDTO>& stationStats)
+{
+    if (!m_stationTable) return;
     
-    // 刷新站点表格
-    if (m_stationTable) {
-        m_stationTable->setRowCount(0);
+    m_stationTable->setRowCount(0);
+    
+    for (const auto& stats : stationStats) {
+        int row = m_stationTable->rowCount();
+        m_stationTable->insertRow(row);
         
-        auto stationStats = m_stationService->getStationStats();
-        for (const auto& stats : stationStats) {
-            int row = m_stationTable->rowCount();
-            m_stationTable->insertRow(row);
-            
-            // 站点名称
-            m_stationTable->setItem(row, 0, new QTableWidgetItem(stats.name));
-            
-            // 在线状态
-            auto *statusItem = new QTableWidgetItem(stats.isOnline ? tr("🟢 在线") : tr("🔴 离线"));
-            statusItem->setForeground(QBrush(stats.isOnline ? QColor("#00d68f") : QColor("#ff3d71")));
-            m_stationTable->setItem(row, 1, statusItem);
-            
-            // 总雨具数
-            m_stationTable->setItem(row, 2, new QTableWidgetItem(QString::number(stats.totalGears)));
-            
-            // 可借数量
-            auto *availableItem = new QTableWidgetItem(QString::number(stats.availableCount));
-            availableItem->setForeground(QBrush(QColor("#00d68f")));
-            m_stationTable->setItem(row, 3, availableItem);
-            
-            // 已借出
-            auto *borrowedItem = new QTableWidgetItem(QString::number(stats.borrowedCount));
-            borrowedItem->setForeground(QBrush(QColor("#667eea")));
-            m_stationTable->setItem(row, 4, borrowedItem);
+        // 站点名称
+        m_stationTable->setItem(row, 0, new QTableWidgetItem(stats.name));
+        
+        // 在线状态
+        auto *statusItem = new QTableWidgetItem(stats.isOnline ? tr("🟢 在线") : tr("🔴 离线"));
+        statusItem->setForeground(QBrush(stats.isOnline ? QColor("#00d68f") : QColor("#ff3d71")));
+        m_stationTable->setItem(row, 1, statusItem);
+        
+        // 总雨具数
+        m_stationTable->setItem(row, 2, new QTableWidgetItem(QString::number(stats.totalGears)));
+        
+        // 可借数量
+        auto *availableItem = new QTableWidgetItem(QString::number(stats.availableCount));
+        availableItem->setForeground(QBrush(QColor("#00d68f")));
+        m_stationTable->setItem(row, 3, availableItem);
+        
+        // 已借出
+        auto *borrowedItem = new QTableWidgetItem(QString::number(stats.borrowedCount));
+        borrowedItem->setForeground(QBrush(QColor("#667eea")));
+        m_stationTable->setItem(row, 4, borrowedItem);
+        
+        // 故障数
+        auto *brokenItem = new QTableWidgetItem(QString::number(stats.brokenCount));
+        brokenItem->setForeground(QBrush(QColor("#ff3d71")));
+        m_stationTable->setItem(row, 5, brokenItem);
+        
+        // 操作按钮（修改在线状态）
+        auto *btnModify = new QPushButton(stats.isOnline ? tr("设为离线") : tr("设为在线"));
+        btnModify->setStyleSheet(Styles::Buttons::secondary());
+        btnModify->setCursor(Qt::PointingHandCursor);
+        
+        connect(btnModify, &QPushButton::clicked, this, [this, stats = stats]() {
+            QDialog dialog(this);
+            dialog.setWindowTitle(tr("修改站点在线状态"));
+            dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
+            auto *layout = new QVBoxLayout(&dialog);
+            layout->setSpacing(16);
+            layout->setContentsMargins(24, 24, 24, 24);
             
-            // 故障数
-            auto *brokenItem = new QTableWidgetItem(QString::number(stats.brokenCount));
-            brokenItem->setForeground(QBrush(QColor("#ff3d71")));
-            m_stationTable->setItem(row, 5, brokenItem);
+            auto *label = new QLabel(tr("站点: %1\n当前状态: %2")
+                .arg(stats.name)
+                .arg(stats.isOnline ? tr("🟢 在线") : tr("🔴 离线")));
+            label->setStyleSheet(Styles::Labels::info());
+            layout->addWidget(label);
             
-            // 操作按钮（修改在线状态）
-            auto *btnModify = new QPushButton(stats.isOnline ? tr("设为离线") : tr("设为在线"));
-            btnModify->setStyleSheet(Styles::Buttons::secondary());
-            btnModify->setCursor(Qt::PointingHandCursor);
+            auto *combo = new QComboBox(&dialog);
+            combo->addItem(tr("🟢 在线"), true);
+            combo->addItem(tr("🔴 离线"), false);
+            combo->setCurrentIndex(stats.isOnline ? 0 : 1);
+            layout->addWidget(combo);
             
-            connect(btnModify, &QPushButton::clicked, this, [this, stats = stats]() {
-                QDialog dialog(this);
-                dialog.setWindowTitle(tr("修改站点在线状态"));
-                dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
-                auto *layout = new QVBoxLayout(&dialog);
-                layout->setSpacing(16);
-                layout->setContentsMargins(24, 24, 24, 24);
-                
-                auto *label = new QLabel(tr("站点: %1\n当前状态: %2")
-                    .arg(stats.name)
-                    .arg(stats.isOnline ? tr("🟢 在线") : tr("🔴 离线")));
-                label->setStyleSheet(Styles::Labels::info());
-                layout->addWidget(label);
-                
-                auto *combo = new QComboBox(&dialog);
-                combo->addItem(tr("🟢 在线"), true);
-                combo->addItem(tr("🔴 离线"), false);
-                combo->setCurrentIndex(stats.isOnline ? 0 : 1);
-                layout->addWidget(combo);
-                
-                auto *btnLayout = new QHBoxLayout();
-                auto *btnOk = new QPushButton(tr("确定"), &dialog);
-                btnOk->setStyleSheet(Styles::Buttons::primary());
-                auto *btnCancel = new QPushButton(tr("取消"), &dialog);
-                btnCancel->setStyleSheet(Styles::Buttons::back());
-                connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
-                connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
-                btnLayout->addWidget(btnOk);
-                btnLayout->addWidget(btnCancel);
-                layout->addLayout(btnLayout);
-                
-                if (dialog.exec() == QDialog::Accepted) {
-                    bool newStatus = combo->currentData().toBool();
-                    if (m_stationService->updateStationStatus(stats.stationId, newStatus)) {
-                        QMessageBox::information(this, tr("成功"), tr("站点在线状态已更新"));
-                        refreshDashboardData();
-                    } else {
-                        QMessageBox::critical(this, tr("失败"), tr("更新失败，请重试"));
-                    }
-                }
-            });
+            auto *btnLayout = new QHBoxLayout();
+            auto *btnOk = new QPushButton(tr("确定"), &dialog);
+            btnOk->setStyleSheet(Styles::Buttons::primary());
+            auto *btnCancel = new QPushButton(tr("取消"), &dialog);
+            btnCancel->setStyleSheet(Styles::Buttons::back());
+            connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
+            connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
+            btnLayout->addWidget(btnOk);
+            btnLayout->addWidget(btnCancel);
+            layout->addLayout(btnLayout);
             
-            m_stationTable->setCellWidget(row, 6, btnModify);
-        }
+            if (dialog.exec() == QDialog::Accepted) {
+                bool newStatus = combo->currentData().toBool();
+                m_stationService->updateStationStatusAsync(stats.stationId, newStatus, stats.version, this,
+                    [this](WriteResult result) {
+                        if (result == WriteResult::Ok) {
+                            QMessageBox::information(this, tr("成功"), tr("站点在线状态已更新"));
+                            refreshDashboardData();
+                        } else if (result == WriteResult::Conflict) {
+                            QMessageBox::warning(this, tr("提示"), tr("站点状态已被其他操作修改，已刷新，请确认后重试"));
+                            refreshDashboardData();
+                        } else {
+                            QMessageBox::critical(this, tr("失败"), tr("更新失败，请重试"));
+                        }
+                    });
+            }
+        });
+        
+        m_stationTable->setCellWidget(row, 6, btnModify);
     }
 }
 
@@ -754,242 +1040,429 @@ void AdminMainWindow::refreshGearManageData()
     
     if (selectedStationId != lastStationId || selectedSlotId != lastSlotId) {
         m_gearCurrentPage = 1;
+        m_gearCursor.clear();
+        m_gearDirection = PageDirection::After;
         lastStationId = selectedStationId;
         lastSlotId = selectedSlotId;
     }
     
-    m_gearTable->setRowCount(0);
-    
-    // 填充站点下拉框（只在第一次）
-    if (m_gearStationCombo && m_gearStationCombo->count() == 1) {
-        auto stationStats = m_stationService->getStationStats();
-        for (const auto& stats : stationStats) {
-            m_gearStationCombo->addItem(stats.name, stats.stationId);
+    // 站点列表、当前页和总数在DB工作线程一起查询，返回后再填表；上一轮还没返回的刷新直接作废
+    m_gearToken.cancel();
+    m_gearToken = CancelToken();
+
+    struct GearData {
+        QVector<StationStats> stationStats;  // 站点列表只查一次，下拉框和表格里的站点名称共用
+        GearPage page;
+        bool restarted = false;  // 当前页的数据都没了，改取了第一页
+        int totalCount = 0;
+    };
+    Admin_StationService *stationService = m_stationService.get();
+    Admin_GearService *gearService = m_gearService.get();
+    const QString cursor = m_gearCursor;
+    const PageDirection direction = m_gearDirection;
+    const bool allowCachedCount = !m_gearForceCount;
+    m_gearForceCount = false;
+    DbExecutor::submit(this, [stationService, gearService, selectedStationId, selectedSlotId, cursor, direction, allowCachedCount]() {
+        GearData data;
+        data.stationStats = stationService->getStationStats();
+        // 按游标取当前页，总数在定时刷新时复用缓存，手动刷新才重新计数
+        data.page = gearService->getGearPage(selectedStationId, selectedSlotId, cursor, direction, GEAR_PAGE_SIZE);
+        if (data.page.gears.isEmpty() && !cursor.isEmpty()) {
+            // 当前页的数据都没了（被删除或筛选结果变少），回到第一页
+            data.restarted = true;
+            data.page = gearService->getGearPage(selectedStationId, selectedSlotId, QString(), PageDirection::After, GEAR_PAGE_SIZE);
         }
-    }
+        data.totalCount = gearService->getGearCount(selectedStationId, selectedSlotId, allowCachedCount);
+        return data;
+    }, [this](GearData data) {
+        m_gearTable->setRowCount(0);
+        const auto& stationStats = data.stationStats;
+        const auto& page = data.page;
     
-    // 获取总数和当前页数据
-    int totalCount = m_gearService->getGearCount(selectedStationId, selectedSlotId);
-    int totalPages = (totalCount + GEAR_PAGE_SIZE - 1) / GEAR_PAGE_SIZE;  // 向上取整
-    if (totalPages == 0) totalPages = 1;  // 至少1页
+        // 填充站点下拉框（只在第一次）
+        if (m_gearStationCombo && m_gearStationCombo->count() == 1) {
+            for (const auto& stats : stationStats) {
+                m_gearStationCombo->addItem(stats.name, stats.stationId);
+            }
+        }
     
-    // 确保当前页不超出范围
-    if (m_gearCurrentPage > totalPages) {
-        m_gearCurrentPage = totalPages;
-    }
-    if (m_gearCurrentPage < 1) {
-        m_gearCurrentPage = 1;
-    }
+        if (data.restarted) {
+            m_gearCurrentPage = 1;
+        }
+        // 页码只是估计（前面可能插入了新数据），以实际有没有上一页为准
+        if (!page.hasPrev) {
+            m_gearCurrentPage = 1;
+        } else if (m_gearCurrentPage < 2) {
+            m_gearCurrentPage = 2;
+        }
+        // 之后的刷新从本页第一条开始原地重新加载
+        m_gearFirstId = page.firstId();
+        m_gearLastId = page.lastId();
+        if (!m_gearFirstId.isEmpty() && page.hasPrev) {
+            m_gearCursor = m_gearFirstId;
+            m_gearDirection = PageDirection::AtOrAfter;
+        } else {
+            m_gearCursor.clear();
+            m_gearDirection = PageDirection::After;
+        }
+        const auto& gears = page.gears;
     
-    // 计算分页参数
-    int offset = (m_gearCurrentPage - 1) * GEAR_PAGE_SIZE;
-    auto gears = m_gearService->getAllGears(selectedStationId, selectedSlotId, GEAR_PAGE_SIZE, offset);
+        int totalCount = data.totalCount;
+        int totalPages = (totalCount + GEAR_PAGE_SIZE - 1) / GEAR_PAGE_SIZE;  // 向上取整
+        totalPages = qMax(totalPages, m_gearCurrentPage);  // 计数有缓存，可能略滞后
     
-    // 更新分页信息
-    if (m_gearPageInfo) {
-        m_gearPageInfo->setText(tr("第 %1 页，共 %2 页（共 %3 条记录）")
-            .arg(m_gearCurrentPage).arg(totalPages).arg(totalCount));
-    }
+        // 更新分页信息
+        if (m_gearPageInfo) {
+            m_gearPageInfo->setText(tr("第 %1 页，共 %2 页（共 %3 条记录）")
+                .arg(m_gearCurrentPage).arg(totalPages).arg(totalCount));
+        }
     
-    // 更新分页按钮状态
-    if (m_gearPrevBtn) {
-        m_gearPrevBtn->setEnabled(m_gearCurrentPage > 1);
-    }
-    if (m_gearNextBtn) {
-        m_gearNextBtn->setEnabled(m_gearCurrentPage < totalPages);
-    }
+        // 更新分页按钮状态
+        if (m_gearPrevBtn) {
+            m_gearPrevBtn->setEnabled(page.hasPrev);
+        }
+        if (m_gearNextBtn) {
+            m_gearNextBtn->setEnabled(page.hasNext);
+        }
     
-    QStringList typeNames = {tr("未知"), tr("普通塑料伞"), tr("高质量抗风伞"), tr("专用遮阳伞"), tr("雨衣")};
-    QStringList statusNames = {tr("未知"), tr("可借"), tr("已借出"), tr("故障")};
+        QStringList typeNames = {tr("未知"), tr("普通塑料伞"), tr("高质量抗风伞"), tr("专用遮阳伞"), tr("雨衣")};
+        QStringList statusNames = {tr("未知"), tr("可借"), tr("已借出"), tr("故障")};
     
-    // 获取站点名称映射
-    auto stationStats = m_stationService->getStationStats();
-    QMap<int, QString> stationNames;
-    for (const auto& stats : stationStats) {
-        stationNames[stats.stationId] = stats.name;
-    }
+        // 获取站点名称映射
+        QMap<int, QString> stationNames;
+        for (const auto& stats : stationStats) {
+            stationNames[stats.stationId] = stats.name;
+        }
     
-    for (const auto& gear : gears) {
-        int row = m_gearTable->rowCount();
-        m_gearTable->insertRow(row);
+        for (const auto& gear : gears) {
+            int row = m_gearTable->rowCount();
+            m_gearTable->insertRow(row);
         
-        m_gearTable->setItem(row, 0, new QTableWidgetItem(gear.gearId));
-        m_gearTable->setItem(row, 1, new QTableWidgetItem(
-            gear.typeId >= 1 && gear.typeId <= 4 ? typeNames[gear.typeId] : tr("未知")));
+            m_gearTable->setItem(row, 0, new QTableWidgetItem(gear.gearId));
+            m_gearTable->setItem(row, 1, new QTableWidgetItem(
+                gear.typeId >= 1 && gear.typeId <= 4 ? typeNames[gear.typeId] : tr("未知")));
         
-        QString stationDisplay = gear.status == 2 ? tr("已借出") : stationNames.value(gear.stationId, tr("未知"));
-        m_gearTable->setItem(row, 2, new QTableWidgetItem(stationDisplay));
+            QString stationDisplay = gear.status == 2 ? tr("已借出") : stationNames.value(gear.stationId, tr("未知"));
+            m_gearTable->setItem(row, 2, new QTableWidgetItem(stationDisplay));
         
-        QString slotDisplay = gear.status == 2 ? tr("-") : (gear.slotId > 0 ? QStringLiteral("#%1").arg(gear.slotId) : tr("无"));
-        m_gearTable->setItem(row, 3, new QTableWidgetItem(slotDisplay));
+            QString slotDisplay = gear.status == 2 ? tr("-") : (gear.slotId > 0 ? QStringLiteral("#%1").arg(gear.slotId) : tr("无"));
+            m_gearTable->setItem(row, 3, new QTableWidgetItem(slotDisplay));
         
-        auto *statusItem = new QTableWidgetItem(
-            gear.status >= 1 && gear.status <= 3 ? statusNames[gear.status] : tr("未知"));
-        if (gear.status == 1) {
-            statusItem->setForeground(QBrush(QColor("#00d68f")));
-        } else if (gear.status == 2) {
-            statusItem->setForeground(QBrush(QColor("#8f8fa3")));
-        } else if (gear.status == 3) {
-            statusItem->setForeground(QBrush(QColor("#ff3d71")));
-        }
-        m_gearTable->setItem(row, 4, statusItem);
+            auto *statusItem = new QTableWidgetItem(
+                gear.status >= 1 && gear.status <= 3 ? statusNames[gear.status] : tr("未知"));
+            if (gear.status == 1) {
+                statusItem->setForeground(QBrush(QColor("#00d68f")));
+            } else if (gear.status == 2) {
+                statusItem->setForeground(QBrush(QColor("#8f8fa3")));
+            } else if (gear.status == 3) {
+                statusItem->setForeground(QBrush(QColor("#ff3d71")));
+            }
+            m_gearTable->setItem(row, 4, statusItem);
         
-        // 操作按钮
-        auto *btnModify = new QPushButton(tr("修改状态"));
-        btnModify->setStyleSheet(Styles::Buttons::secondary());
-        btnModify->setCursor(Qt::PointingHandCursor);
+            // 操作按钮
+            auto *btnModify = new QPushButton(tr("修改状态"));
+            btnModify->setStyleSheet(Styles::Buttons::secondary());
+            btnModify->setCursor(Qt::PointingHandCursor);
         
-        connect(btnModify, &QPushButton::clicked, this, [this, gear = gear]() {
-            QDialog dialog(this);
-            dialog.setWindowTitle(tr("修改雨具状态"));
-            dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
-            auto *layout = new QVBoxLayout(&dialog);
-            layout->setSpacing(16);
-            layout->setContentsMargins(24, 24, 24, 24);
+            connect(btnModify, &QPushButton::clicked, this, [this, gear = gear]() {
+                QDialog dialog(this);
+                dialog.setWindowTitle(tr("修改雨具状态"));
+                dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
+                auto *layout = new QVBoxLayout(&dialog);
+                layout->setSpacing(16);
+                layout->setContentsMargins(24, 24, 24, 24);
             
-            auto *label = new QLabel(tr("雨具ID: %1\n当前状态: %2")
-                .arg(gear.gearId)
-                .arg(gear.status == 1 ? tr("可借") : (gear.status == 2 ? tr("已借出") : tr("故障"))));
-            label->setStyleSheet(Styles::Labels::info());
-            layout->addWidget(label);
+                auto *label = new QLabel(tr("雨具ID: %1\n当前状态: %2")
+                    .arg(gear.gearId)
+                    .arg(gear.status == 1 ? tr("可借") : (gear.status == 2 ? tr("已借出") : tr("故障"))));
+                label->setStyleSheet(Styles::Labels::info());
+                layout->addWidget(label);
             
-            auto *combo = new QComboBox(&dialog);
-            combo->addItem(tr("可借"), 1);
-            combo->addItem(tr("已借出"), 2);
-            combo->addItem(tr("故障"), 3);
-            combo->setCurrentIndex(gear.status - 1);
-            layout->addWidget(combo);
+                auto *combo = new QComboBox(&dialog);
+                combo->addItem(tr("可借"), 1);
+                combo->addItem(tr("已借出"), 2);
+                combo->addItem(tr("故障"), 3);
+                combo->setCurrentIndex(gear.status - 1);
+                layout->addWidget(combo);
             
-            auto *btnLayout = new QHBoxLayout();
-            auto *btnOk = new QPushButton(tr("确定"), &dialog);
-            btnOk->setStyleSheet(Styles::Buttons::primary());
-            auto *btnCancel = new QPushButton(tr("取消"), &dialog);
-            btnCancel->setStyleSheet(Styles::Buttons::back());
-            connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
-            connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
-            btnLayout->addWidget(btnOk);
-            btnLayout->addWidget(btnCancel);
-            layout->addLayout(btnLayout);
+                auto *btnLayout = new QHBoxLayout();
+                auto *btnOk = new QPushButton(tr("确定"), &dialog);
+                btnOk->setStyleSheet(Styles::Buttons::primary());
+                auto *btnCancel = new QPushButton(tr("取消"), &dialog);
+                btnCancel->setStyleSheet(Styles::Buttons::back());
+                connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
+                connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
+                btnLayout->addWidget(btnOk);
+                btnLayout->addWidget(btnCancel);
+                layout->addLayout(btnLayout);
             
-            if (dialog.exec() == QDialog::Accepted) {
-                int newStatus = combo->currentData().toInt();
-                if (m_gearService->updateGearStatus(gear.gearId, newStatus)) {
-                    QMessageBox::information(this, tr("成功"), tr("雨具状态已更新"));
-                    refreshGearManageData();
-                } else {
-                    QMessageBox::critical(this, tr("失败"), tr("更新失败，请重试"));
+                if (dialog.exec() == QDialog::Accepted) {
+                    int newStatus = combo->currentData().toInt();
+                    m_gearService->updateGearStatusAsync(gear.gearId, newStatus, gear.version, this,
+                        [this](WriteResult result) {
+                            if (result == WriteResult::Ok) {
+                                QMessageBox::information(this, tr("成功"), tr("雨具状态已更新"));
+                                refreshGearManageData();
+                            } else if (result == WriteResult::Conflict) {
+                                QMessageBox::warning(this, tr("提示"), tr("雨具刚被借出、归还或被其他管理员修改，已刷新，请确认后重试"));
+                                refreshGearManageData();
+                            } else {
+                                QMessageBox::critical(this, tr("失败"), tr("更新失败，请重试"));
+                            }
+                        });
                 }
-            }
-        });
+            });
         
-        m_gearTable->setCellWidget(row, 5, btnModify);
-    }
+            m_gearTable->setCellWidget(row, 5, btnModify);
+        }
+    }, m_gearToken);
 }
 
 void AdminMainWindow::refreshUserManageData()
 {
     if (!m_userTable) return;
     
-    m_userTable->setRowCount(0);
-    
     QString searchText = m_userSearchInput ? m_userSearchInput->text().trimmed() : QString();
-    auto users = m_userService->getAllUsers(searchText);
+    if (m_userCurrentPage < 1) {
+        m_userCurrentPage = 1;
+    }
+
+    // 查询在DB工作线程执行，返回后再填表；上一轮还没返回的刷新直接作废
+    m_userToken.cancel();
+    m_userToken = CancelToken();
+
+    struct UserData {
+        UserPage page;
+        int currentPage = 1;
+        int totalPages = 1;
+    };
+    Admin_UserService *userService = m_userService.get();
+    const int requestedPage = m_userCurrentPage;
+    DbExecutor::submit(this, [userService, searchText, requestedPage]() {
+        UserData data;
+        data.currentPage = requestedPage;
+        data.page = userService->searchUsers(searchText, USER_PAGE_SIZE, (data.currentPage - 1) * USER_PAGE_SIZE);
+        data.totalPages = (data.page.totalCount + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE;  // 向上取整
+        if (data.totalPages == 0) data.totalPages = 1;  // 至少1页
+        
+        // 数据变少导致当前页超出范围时回到最后一页
+        if (data.currentPage > data.totalPages) {
+            data.currentPage = data.totalPages;
+            data.page = userService->searchUsers(searchText, USER_PAGE_SIZE, (data.currentPage - 1) * USER_PAGE_SIZE);
+        }
+        return data;
+    }, [this](UserData data) {
+        m_userTable->setRowCount(0);
+        m_userCurrentPage = data.currentPage;
+        const int totalPages = data.totalPages;
+        const auto& page = data.page;
+    
+        if (m_userPageInfo) {
+            m_userPageInfo->setText(tr("第 %1 页，共 %2 页（共 %3 条记录）")
+                .arg(m_userCurrentPage).arg(totalPages).arg(page.totalCount));
+        }
+        if (m_userPrevBtn) {
+            m_userPrevBtn->setEnabled(m_userCurrentPage > 1);
+        }
+        if (m_userNextBtn) {
+            m_userNextBtn->setEnabled(m_userCurrentPage < totalPages);
+        }
     
-    QStringList roleNames = {tr("学生"), tr("教职工"), tr(""), tr(""), tr(""), tr(""), tr(""), tr(""), tr(""), tr("管理员")};
+        QStringList roleNames = {tr("学生"), tr("教职工"), tr(""), tr(""), tr(""), tr(""), tr(""), tr(""), tr(""), tr("管理员")};
     
-    for (const auto& user : users) {
-        int row = m_userTable->rowCount();
-        m_userTable->insertRow(row);
+        for (const auto& user : page.users) {
+            int row = m_userTable->rowCount();
+            m_userTable->insertRow(row);
         
-        m_userTable->setItem(row, 0, new QTableWidgetItem(user.get_id()));
-        m_userTable->setItem(row, 1, new QTableWidgetItem(user.get_name()));
-        m_userTable->setItem(row, 2, new QTableWidgetItem(
-            user.get_role() >= 0 && user.get_role() < roleNames.size() ? roleNames[user.get_role()] : tr("未知")));
+            m_userTable->setItem(row, 0, new QTableWidgetItem(user.userId));
+            m_userTable->setItem(row, 1, new QTableWidgetItem(user.realName));
+            m_userTable->setItem(row, 2, new QTableWidgetItem(
+                user.role >= 0 && user.role < roleNames.size() ? roleNames[user.role] : tr("未知")));
         
-        auto *creditItem = new QTableWidgetItem(QString("￥%1").arg(QString::number(user.get_credit(), 'f', 2)));
-        creditItem->setForeground(QBrush(QColor("#00d68f")));
-        m_userTable->setItem(row, 3, creditItem);
+            auto *creditItem = new QTableWidgetItem(QString("￥%1").arg(QString::number(user.credit, 'f', 2)));
+            creditItem->setForeground(QBrush(QColor("#00d68f")));
+            m_userTable->setItem(row, 3, creditItem);
         
-        auto *statusItem = new QTableWidgetItem(user.get_is_active() ? tr("已激活") : tr("未激活"));
-        statusItem->setForeground(QBrush(user.get_is_active() ? QColor("#00d68f") : QColor("#8f8fa3")));
-        m_userTable->setItem(row, 4, statusItem);
+            auto *statusItem = new QTableWidgetItem(user.isActive ? tr("已激活") : tr("未激活"));
+            statusItem->setForeground(QBrush(user.isActive ? QColor("#00d68f") : QColor("#8f8fa3")));
+            m_userTable->setItem(row, 4, statusItem);
         
-        // 重置密码按钮
-        auto *btnResetPwd = new QPushButton(tr("重置密码"));
-        btnResetPwd->setStyleSheet(Styles::Buttons::secondary());
-        btnResetPwd->setCursor(Qt::PointingHandCursor);
+            // 重置密码按钮
+            auto *btnResetPwd = new QPushButton(tr("重置密码"));
+            btnResetPwd->setStyleSheet(Styles::Buttons::secondary());
+            btnResetPwd->setCursor(Qt::PointingHandCursor);
         
-        connect(btnResetPwd, &QPushButton::clicked, this, [this, user = user]() {
-            QDialog dialog(this);
-            dialog.setWindowTitle(tr("重置密码"));
-            dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
-            auto *layout = new QVBoxLayout(&dialog);
-            layout->setSpacing(16);
-            layout->setContentsMargins(24, 24, 24, 24);
+            connect(btnResetPwd, &QPushButton::clicked, this, [this, user = user]() {
+                QDialog dialog(this);
+                dialog.setWindowTitle(tr("重置密码"));
+                dialog.setStyleSheet("QDialog { background-color: #ffffff; }");
+                auto *layout = new QVBoxLayout(&dialog);
+                layout->setSpacing(16);
+                layout->setContentsMargins(24, 24, 24, 24);
             
-            auto *label = new QLabel(tr("用户: %1 (%2)").arg(user.get_id()).arg(user.get_name()));
-            label->setStyleSheet(Styles::Labels::info());
-            layout->addWidget(label);
+                auto *label = new QLabel(tr("用户: %1 (%2)").arg(user.userId).arg(user.realName));
+                label->setStyleSheet(Styles::Labels::info());
+                layout->addWidget(label);
             
-            auto *inputPwd = new QLineEdit(&dialog);
-            inputPwd->setPlaceholderText(tr("请输入新密码"));
-            inputPwd->setEchoMode(QLineEdit::Password);
-            layout->addWidget(inputPwd);
+                auto *inputPwd = new QLineEdit(&dialog);
+                inputPwd->setPlaceholderText(tr("请输入新密码"));
+                inputPwd->setEchoMode(QLineEdit::Password);
+                layout->addWidget(inputPwd);
             
-            auto *btnLayout = new QHBoxLayout();
-            auto *btnOk = new QPushButton(tr("确定"), &dialog);
-            btnOk->setStyleSheet(Styles::Buttons::primary());
-            auto *btnCancel = new QPushButton(tr("取消"), &dialog);
-            btnCancel->setStyleSheet(Styles::Buttons::back());
-            connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
-            connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
-            btnLayout->addWidget(btnOk);
-            btnLayout->addWidget(btnCancel);
-            layout->addLayout(btnLayout);
+                auto *btnLayout = new QHBoxLayout();
+                auto *btnOk = new QPushButton(tr("确定"), &dialog);
+                btnOk->setStyleSheet(Styles::Buttons::primary());
+                auto *btnCancel = new QPushButton(tr("取消"), &dialog);
+                btnCancel->setStyleSheet(Styles::Buttons::back());
+                connect(btnOk, &QPushButton::clicked, &dialog, &QDialog::accept);
+                connect(btnCancel, &QPushButton::clicked, &dialog, &QDialog::reject);
+                btnLayout->addWidget(btnOk);
+                btnLayout->addWidget(btnCancel);
+                layout->addLayout(btnLayout);
             
-            if (dialog.exec() == QDialog::Accepted) {
-                QString newPassword = inputPwd->text();
-                if (newPassword.length() < 6) {
-                    QMessageBox::warning(this, tr("提示"), tr("密码长度至少为6位"));
-                    return;
-                }
-                if (m_userService->resetUserPassword(user.get_id(), newPassword)) {
-                    QMessageBox::information(this, tr("成功"), tr("密码已重置"));
-                } else {
-                    QMessageBox::critical(this, tr("失败"), tr("重置失败，请重试"));
+                if (dialog.exec() == QDialog::Accepted) {
+                    QString newPassword = inputPwd->text();
+                    if (newPassword.length() < 6) {
+                        QMessageBox::warning(this, tr("提示"), tr("密码长度至少为6位"));
+                        return;
+                    }
+                    m_userService->resetUserPasswordAsync(user.userId, newPassword, this, [this](bool ok) {
+                        if (ok) {
+                            QMessageBox::information(this, tr("成功"), tr("密码已重置"));
+                        } else {
+                            QMessageBox::critical(this, tr("失败"), tr("重置失败，请重试"));
+                        }
+                    });
                 }
-            }
-        });
+            });
         
-        m_userTable->setCellWidget(row, 5, btnResetPwd);
+            m_userTable->setCellWidget(row, 5, btnResetPwd);
+        }
+    }, m_userToken);
+}
+
+OrderFilter AdminMainWindow::currentOrderFilter() const
+{
+    OrderFilter filter;
+    if (m_orderUserInput) filter.userId = m_orderUserInput->text().trimmed();
+    if (m_orderGearInput) filter.gearId = m_orderGearInput->text().trimmed();
+    if (m_orderStationCombo) filter.stationId = m_orderStationCombo->currentData().toInt();
+    if (m_orderStatusCombo) filter.status = static_cast<OrderStatus>(m_orderStatusCombo->currentData().toInt());
+    int days = m_orderRangeCombo ? m_orderRangeCombo->currentData().toInt() : 0;
+    if (days > 0) {
+        filter.borrowFrom = QDateTime(QDate::currentDate().addDays(1 - days), QTime(0, 0));
     }
+    return filter;
+}
+
+void AdminMainWindow::resetOrderPaging()
+{
+    m_orderCurrentPage = 1;
+    m_orderCursor = OrderCursor();
+    m_orderDirection = PageDirection::After;
+    refreshOrderManageData();
 }
 
 void AdminMainWindow::refreshOrderManageData()
 {
     if (!m_orderTable) return;
     
-    m_orderTable->setRowCount(0);
+    // 站点列表（只在第一次）和当前页在DB工作线程查询，返回后再填表；上一轮还没返回的刷新直接作废
+    m_orderToken.cancel();
+    m_orderToken = CancelToken();
+
+    struct OrderData {
+        QVector<StationStats> stationStats;
+        OrderPage page;
+        bool restarted = false;  // 当前页的数据都没了，改取了第一页
+    };
+    Admin_StationService *stationService = m_stationService.get();
+    Admin_OrderService *orderService = m_orderService.get();
+    const bool needStations = m_orderStationCombo && m_orderStationCombo->count() == 1;
+    const OrderFilter filter = currentOrderFilter();
+    const OrderCursor cursor = m_orderCursor;
+    const PageDirection direction = m_orderDirection;
+    DbExecutor::submit(this, [stationService, orderService, needStations, filter, cursor, direction]() {
+        OrderData data;
+        if (needStations) data.stationStats = stationService->getStationStats();
+        data.page = orderService->queryOrders(filter, cursor, direction, ORDER_PAGE_SIZE);
+        if (data.page.orders.isEmpty() && !cursor.isNull()) {
+            // 当前页的数据都没了，回到第一页
+            data.restarted = true;
+            data.page = orderService->queryOrders(filter, OrderCursor(), PageDirection::After, ORDER_PAGE_SIZE);
+        }
+        return data;
+    }, [this](OrderData data) {
+        m_orderTable->setRowCount(0);
+        const auto& page = data.page;
+    
+        // 填充站点下拉框（只在第一次）
+        if (m_orderStationCombo && m_orderStationCombo->count() == 1) {
+            QSignalBlocker blocker(m_orderStationCombo);
+            for (const auto& stats : data.stationStats) {
+                m_orderStationCombo->addItem(stats.name, stats.stationId);
+            }
+        }
     
-    auto orders = m_orderService->getRecentOrders(100);
+        if (data.restarted) {
+            m_orderCurrentPage = 1;
+        }
+        // 页码只是估计（期间可能有新订单），以实际有没有上一页为准
+        if (!page.hasPrev) {
+            m_orderCurrentPage = 1;
+        } else if (m_orderCurrentPage < 2) {
+            m_orderCurrentPage = 2;
+        }
+        // 之后的刷新从本页第一条开始原地重新加载；第一页总是重新取最新的订单
+        m_orderFirst = page.firstCursor();
+        m_orderLast = page.lastCursor();
+        if (page.hasPrev && !m_orderFirst.isNull()) {
+            m_orderCursor = m_orderFirst;
+            m_orderDirection = PageDirection::AtOrAfter;
+        } else {
+            m_orderCursor = OrderCursor();
+            m_orderDirection = PageDirection::After;
+        }
     
-    for (const auto& order : orders) {
-        int row = m_orderTable->rowCount();
-        m_orderTable->insertRow(row);
+        if (m_orderPageInfo) {
+            m_orderPageInfo->setText(tr("第 %1 页（每页 %2 条）").arg(m_orderCurrentPage).arg(ORDER_PAGE_SIZE));
+        }
+        if (m_orderPrevBtn) {
+            m_orderPrevBtn->setEnabled(page.hasPrev);
+        }
+        if (m_orderNextBtn) {
+            m_orderNextBtn->setEnabled(page.hasNext);
+        }
+    
+        QStringList typeNames = {tr("未知"), tr("普通塑料伞"), tr("高质量抗风伞"), tr("专用遮阳伞"), tr("雨衣")};
+    
+        for (const auto& order : page.orders) {
+            int row = m_orderTable->rowCount();
+            m_orderTable->insertRow(row);
         
-        m_orderTable->setItem(row, 0, new QTableWidgetItem(QString::number(order.recordId)));
-        m_orderTable->setItem(row, 1, new QTableWidgetItem(order.userId));
-        m_orderTable->setItem(row, 2, new QTableWidgetItem(order.gearId));
-        m_orderTable->setItem(row, 3, new QTableWidgetItem(order.borrowTime));
+            m_orderTable->setItem(row, 0, new QTableWidgetItem(QString::number(order.recordId)));
+            auto userIt = page.users.constFind(order.userId);
+            m_orderTable->setItem(row, 1, new QTableWidgetItem(userIt == page.users.constEnd() ? order.userId
+                : QStringLiteral("%1 (%2)").arg(order.userId, userIt->realName)));
+            auto gearIt = page.gears.constFind(order.gearId);
+            int typeId = gearIt == page.gears.constEnd() ? 0 : gearIt->typeId;
+            m_orderTable->setItem(row, 2, new QTableWidgetItem(typeId >= 1 && typeId <= 4
+                ? QStringLiteral("%1 (%2)").arg(order.gearId, typeNames[typeId]) : order.gearId));
         
-        auto *returnItem = new QTableWidgetItem(order.returnTime.isEmpty() ? tr("未归还") : order.returnTime);
-        if (order.returnTime.isEmpty()) {
-            returnItem->setForeground(QBrush(QColor("#ffaa00")));
-        }
-        m_orderTable->setItem(row, 4, returnItem);
+            int stationIndex = m_orderStationCombo ? m_orderStationCombo->findData(order.stationId) : -1;
+            QString stationDisplay = order.stationId > 0 && stationIndex > 0 ? m_orderStationCombo->itemText(stationIndex) : tr("-");
+            m_orderTable->setItem(row, 3, new QTableWidgetItem(stationDisplay));
+            m_orderTable->setItem(row, 4, new QTableWidgetItem(order.borrowTime));
         
-        auto *costItem = new QTableWidgetItem(QString("￥%1").arg(QString::number(order.cost, 'f', 2)));
-        m_orderTable->setItem(row, 5, costItem);
-    }
+            auto *returnItem = new QTableWidgetItem(order.returnTime.isEmpty() ? tr("未归还") : order.returnTime);
+            if (order.returnTime.isEmpty()) {
+                returnItem->setForeground(QBrush(QColor("#ffaa00")));
+            }
+            m_orderTable->setItem(row, 5, returnItem);
+        
+            auto *costItem = new QTableWidgetItem(QString("￥%1").arg(QString::number(order.cost, 'f', 2)));
+            m_orderTable->setItem(row, 6, costItem);
+        }
+    }, m_orderToken);
 }
 
@@ -5,7 +5,12 @@
 
 #include <QMainWindow>
 #include <QTimer>
+#include <QVector>
 #include <memory>
+#include "../utils/DbExecutor.h"
+#include "../utils/ConnectionPool.h"
+#include "../dao/PageCursor.h"
+#include "../dao/RecordDao.h"
 
 class QStackedWidget;
 class QWidget;
@@ -21,6 +26,7 @@ class Admin_GearService;
 class Admin_UserService;
 class Admin_OrderService;
 class User;
+struct StationStatsDTO;
 
 class AdminMainWindow : public QMainWindow {
     Q_OBJECT
@@ -55,7 +61,13 @@ private:
     void refreshGearManageData();
     void refreshUserManageData();
     void refreshOrderManageData();
+    void resetOrderPaging();  // 筛选条件变化后回到第一页
+    OrderFilter currentOrderFilter() const;  // 订单页筛选控件当前对应的查询条件
+    void populateStationTable(const QVector<StationStatsDTO>& stationStats); // 用统计结果填充站点表格
     
+    // 数据库状态变化：不可用时暂停定时刷新并显示提示条，恢复后自动继续
+    void onDbHealthChanged(DbHealth state);
+
     // 天气信息（模拟）
     QString getWeatherInfo() const;
 
@@ -71,6 +83,8 @@ private:
 
     QStackedWidget *m_stack { nullptr };
     QTimer *m_refreshTimer { nullptr };
+    QLabel *m_dbStatusBanner { nullptr };
+    bool m_refreshPausedByDb { false };  // 定时刷新是否因数据库不可用而暂停
     
     // 登录页面
     QLineEdit *m_loginUserIdInput { nullptr };
@@ -83,6 +97,7 @@ private:
     QLabel *m_borrowedGearsLabel { nullptr };
     QLabel *m_faultCountLabel { nullptr };
     QTableWidget *m_stationTable { nullptr };
+    CancelToken m_dashboardToken;  // 当前这轮站点统计请求的令牌
     
     // 雨具管理页面
     QComboBox *m_gearStationCombo { nullptr };
@@ -91,14 +106,43 @@ private:
     QLabel *m_gearPageInfo { nullptr };  // 分页信息显示
     QPushButton *m_gearPrevBtn { nullptr };  // 上一页按钮
     QPushButton *m_gearNextBtn { nullptr };  // 下一页按钮
-    int m_gearCurrentPage { 1 };  // 当前页码
+    int m_gearCurrentPage { 1 };  // 当前页码（仅用于显示）
+    QString m_gearCursor;  // 当前页的游标，定时刷新时按它原地重新加载
+    PageDirection m_gearDirection { PageDirection::After };
+    QString m_gearFirstId;  // 当前页第一条，上一页的游标
+    QString m_gearLastId;   // 当前页最后一条，下一页的游标
+    bool m_gearForceCount { false };  // 下次刷新是否重新计数（手动刷新时）
+    CancelToken m_gearToken;  // 当前这轮雨具列表刷新的令牌
     static constexpr int GEAR_PAGE_SIZE = 50;  // 每页显示数量
     
     // 用户管理页面
     QLineEdit *m_userSearchInput { nullptr };
     QTableWidget *m_userTable { nullptr };
+    QLabel *m_userPageInfo { nullptr };
+    QPushButton *m_userPrevBtn { nullptr };
+    QPushButton *m_userNextBtn { nullptr };
+    int m_userCurrentPage { 1 };
+    CancelToken m_userToken;  // 当前这轮用户列表刷新的令牌
+    static constexpr int USER_PAGE_SIZE = 50;
     
     // 订单管理页面
     QTableWidget *m_orderTable { nullptr };
+    QLineEdit *m_orderUserInput { nullptr };
+    QLineEdit *m_orderGearInput { nullptr };
+    QComboBox *m_orderStationCombo { nullptr };
+    QComboBox *m_orderStatusCombo { nullptr };
+    QComboBox *m_orderRangeCombo { nullptr };  // 借出时间范围（最近 N 天）
+    QLabel *m_orderPageInfo { nullptr };
+    QPushButton *m_orderPrevBtn { nullptr };
+    QPushButton *m_orderNextBtn { nullptr };
+    int m_orderCurrentPage { 1 };  // 当前页码（仅用于显示）
+    OrderCursor m_orderCursor;  // 当前页的游标，定时刷新时按它原地重新加载
+    PageDirection m_orderDirection { PageDirection::After };
+    OrderCursor m_orderFirst;  // 当前页第一条，上一页的游标
+    OrderCursor m_orderLast;   // 当前页最后一条，下一页的游标
+    CancelToken m_orderToken;  // 当前这轮订单列表刷新的令牌
+    static constexpr int ORDER_PAGE_SIZE = 50;
+    CancelToken m_orderExportToken;  // 正在进行的订单导出
+    bool m_orderExporting { false };
 };
 
@@ -4,10 +4,61 @@
 #include <QApplication>
 #include <QDir>
 #include <QDebug>
+#include <QStringList>
+#include <QTextStream>
 #include <QSqlDatabase>
 #include "MainWindow.h"
+#include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
+#include "../utils/SlowQueryLog.h"
+#include "../utils/SchemaMigrator.h"
+
+// 连接池配置：默认连本机 MySQL，环境变量可切换后端和只读副本
+static PoolConfig poolConfigFromEnv() {
+    PoolConfig config;
+    // 单站离线部署：设置 RAINHUB_SQLITE=<数据库文件路径 或 :memory:> 时改用内嵌 SQLite 后端
+    const QString sqlitePath = qEnvironmentVariable("RAINHUB_SQLITE");
+    if (!sqlitePath.isEmpty()) {
+        config.backend = DbBackend::Sqlite;
+        config.databaseName = sqlitePath;
+        qDebug() << "[RainHub Admin] Using embedded SQLite backend:" << sqlitePath;
+    }
+    // 读写分离：设置 RAINHUB_REPLICA_HOST=<主机[:端口]> 后，后台统计和列表查询走只读副本
+    const QString replicaHost = qEnvironmentVariable("RAINHUB_REPLICA_HOST");
+    if (!replicaHost.isEmpty()) {
+        const QStringList parts = replicaHost.split(':');
+        config.replicaHostName = parts.first();
+        if (parts.size() > 1) config.replicaPort = parts.at(1).toInt();
+        qDebug() << "[RainHub Admin] Read replica:" << config.replicaHostName << config.replicaPort;
+    }
+    return config;
+}
+
+// 命令行迁移：RainHub_Admin --migrate，执行完所有未执行的结构迁移后退出，不启动界面
+static int runMigrations(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::addLibraryPath(QDir(QCoreApplication::applicationDirPath()).absoluteFilePath("sqldrivers"));
+    ConnectionPool::configure(poolConfigFromEnv());
+
+    MigrationReport report = SchemaMigrator::migrate();
+    QTextStream out(stdout);
+    out << "schema version: " << report.fromVersion << " -> " << report.toVersion
+        << " (latest " << SchemaMigrator::latestVersion() << ")" << Qt::endl;
+    for (const QString& applied : report.applied) {
+        out << "  applied " << applied << Qt::endl;
+    }
+    if (!report.ok) {
+        out << "migration failed: " << report.error << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--migrate") == 0) return runMigrations(argc, argv);
+    }
+
     QApplication app(argc, argv);
     
     // 设置Qt插件路径
@@ -18,6 +69,34 @@ int main(int argc, char *argv[]) {
     qDebug() << "[RainHub Admin] Application dir:" << appDir;
     qDebug() << "[RainHub Admin] Available SQL drivers:" << QSqlDatabase::drivers();
     
+    ConnectionPool::configure(poolConfigFromEnv());
+
+    // 启动时补齐结构迁移（索引等），失败不阻止启动，数据库恢复后可用 --migrate 重新执行
+    MigrationReport migration = SchemaMigrator::migrate();
+    if (!migration.ok) {
+        qCritical() << "[RainHub Admin] Schema migration failed:" << migration.error;
+    } else if (!migration.applied.isEmpty()) {
+        qDebug() << "[RainHub Admin] Schema migrated to version" << migration.toVersion;
+    }
+
+    // 查询耗时统计：设置 RAINHUB_QUERY_METRICS=<报告文件路径> 时开启，每分钟写一次各 DAO 方法的耗时分布
+    const QString metricsPath = qEnvironmentVariable("RAINHUB_QUERY_METRICS");
+    if (!metricsPath.isEmpty()) {
+        QueryMetrics::setEnabled(true);
+        QueryMetrics::startPeriodicDump(metricsPath);
+        qDebug() << "[RainHub Admin] Query metrics enabled, dumping to:" << metricsPath;
+    }
+
+    // 慢查询日志：设置 RAINHUB_SLOW_QUERY_MS=<阈值毫秒> 时开启，RAINHUB_SLOW_QUERY_LOG=<文件路径> 可额外写入文件
+    const int slowQueryMs = qEnvironmentVariableIntValue("RAINHUB_SLOW_QUERY_MS");
+    if (slowQueryMs > 0) {
+        SlowQueryConfig slowConfig;
+        slowConfig.thresholdMs = slowQueryMs;
+        slowConfig.logFile = qEnvironmentVariable("RAINHUB_SLOW_QUERY_LOG");
+        SlowQueryLog::configure(slowConfig);
+        qDebug() << "[RainHub Admin] Slow query log enabled, threshold(ms):" << slowQueryMs;
+    }
+    
     AdminMainWindow w;
     w.show();
     return app.exec();
@@ -21,9 +21,12 @@
 // DAO 用于刷新用户数据
 #include "../dao/UserDao.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/DbExecutor.h"
+#include "../utils/DbHealthMonitor.h"
 
 #include <QApplication>
 #include <QStackedWidget>
+#include <QLabel>
 #include <QVBoxLayout>
 #include <QMessageBox>
 
@@ -40,13 +43,23 @@ MainWindow::MainWindow(QWidget *parent)
     
     setupUi();
     setupConnections();
+
+    // 数据库健康监视：后台探测连接状态，断开时进入降级模式
+    auto *monitor = DbHealthMonitor::instance();
+    connect(monitor, &DbHealthMonitor::stateChanged, this, &MainWindow::onDbHealthChanged);
+    onDbHealthChanged(monitor->state());
+    monitor->start();
     
     switchPage(Page::Welcome);
     setWindowTitle(tr("CampusRain - 校园智能共享雨具系统"));
     resize(900, 680);
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    // 等待DB工作线程上的任务结束，它们还在使用本窗口持有的Service
+    DbExecutor::waitForDone();
+}
 
 void MainWindow::setupUi()
 {
@@ -56,6 +69,13 @@ void MainWindow::setupUi()
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(0);
 
+    // 数据库状态提示条，正常时隐藏
+    m_dbStatusBanner = new QLabel(central);
+    m_dbStatusBanner->setAlignment(Qt::AlignCenter);
+    m_dbStatusBanner->setWordWrap(true);
+    m_dbStatusBanner->hide();
+    layout->addWidget(m_dbStatusBanner);
+
     m_stack = new QStackedWidget(this);
 
     // 创建所有页面
@@ -189,7 +209,6 @@ void MainWindow::setupConnections()
     });
     connect(m_profilePage, &ProfilePage::refreshClicked, this, [this]() {
         refreshUserData();
-        m_profilePage->setUser(m_currentUser);
     });
 
     // InstructionPage 信号
@@ -244,15 +263,45 @@ void MainWindow::onLogout()
     switchPage(Page::Welcome);
 }
 
+void MainWindow::onDbHealthChanged(DbHealth state)
+{
+    switch (state) {
+    case DbHealth::Healthy:
+        m_dbStatusBanner->hide();
+        m_stack->setEnabled(true);
+        break;
+    case DbHealth::Degraded:
+        m_dbStatusBanner->setText(tr("网络不稳定，操作可能较慢，请耐心等待"));
+        m_dbStatusBanner->setStyleSheet("font-size:14px; color:#8a5a00; background-color:#fff4d6; padding:8px;");
+        m_dbStatusBanner->show();
+        m_stack->setEnabled(true);
+        break;
+    case DbHealth::Down:
+        // 借还操作此时必然失败，直接锁定界面，连接恢复后自动解锁
+        m_dbStatusBanner->setText(tr("系统维护中：暂时无法连接服务器，借还功能已暂停，恢复后将自动继续"));
+        m_dbStatusBanner->setStyleSheet("font-size:14px; color:#ffffff; background-color:#d9534f; padding:8px;");
+        m_dbStatusBanner->show();
+        m_stack->setEnabled(false);
+        break;
+    }
+}
+
 void MainWindow::refreshUserData()
 {
     if (!m_currentUser) return;
-    
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    UserDao userDao;
-    auto userOpt = userDao.selectById(db, m_currentUser->get_id());
-    
-    if (userOpt.has_value()) {
+
+    // 查询放到 DbExecutor 的工作线程，回调回到 GUI 线程后再替换当前用户
+    const QString userId = m_currentUser->get_id();
+    DbExecutor::submit(this, [userId]() -> std::optional<User> {
+        if (auto lease = ConnectionPool::acquire()) {
+            UserDao userDao;
+            return userDao.selectById(*lease, userId);
+        }
+        return std::nullopt;
+    }, [this, userId](std::optional<User> userOpt) {
+        // 期间已退出或切换了账号，丢弃过期结果
+        if (!m_currentUser || m_currentUser->get_id() != userId) return;
+        if (!userOpt.has_value()) return;
         m_currentUser = std::make_shared<User>(
             userOpt->get_id(),
             userOpt->get_name(),
@@ -261,6 +310,7 @@ void MainWindow::refreshUserData()
             userOpt->get_credit(),
             userOpt->get_is_active()
         );
-    }
+        m_profilePage->setUser(m_currentUser);
+    });
 }
 
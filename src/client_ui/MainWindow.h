@@ -7,8 +7,10 @@
 #include <QMainWindow>
 #include <memory>
 #include "../Model/User.h"
+#include "../utils/ConnectionPool.h"
 
 class QStackedWidget;
+class QLabel;
 class AuthService;
 class BorrowService;
 class StationService;
@@ -58,9 +60,12 @@ private:
     void onLogout();
     // 刷新用户数据
     void refreshUserData();
+    // 数据库状态变化：不可用时进入降级模式（显示提示条并锁定操作），恢复后自动解除
+    void onDbHealthChanged(DbHealth state);
 
     // 页面切换栈
     QStackedWidget *m_stack { nullptr };
+    QLabel *m_dbStatusBanner { nullptr };
 
     // Service 层（持有所有权）
     std::unique_ptr<AuthService> m_authService;
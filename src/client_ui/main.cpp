@@ -6,6 +6,10 @@
 #include <QDebug>
 #include <QSqlDatabase>
 #include "MainWindow.h"
+#include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
+#include "../utils/SlowQueryLog.h"
+#include "../utils/SchemaMigrator.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
@@ -20,6 +24,39 @@ int main(int argc, char *argv[]) {
     qDebug() << "[Main] Application dir:" << appDir;
     qDebug() << "[Main] Available SQL drivers:" << QSqlDatabase::drivers();
     
+    // 单站离线部署：设置 RAINHUB_SQLITE=<数据库文件路径 或 :memory:> 时改用内嵌 SQLite 后端
+    const QString sqlitePath = qEnvironmentVariable("RAINHUB_SQLITE");
+    if (!sqlitePath.isEmpty()) {
+        PoolConfig config;
+        config.backend = DbBackend::Sqlite;
+        config.databaseName = sqlitePath;
+        ConnectionPool::configure(config);
+        qDebug() << "[Main] Using embedded SQLite backend:" << sqlitePath;
+        // 内嵌库归本终端所有，启动时补齐结构迁移；共享 MySQL 库由管理端负责迁移
+        MigrationReport migration = SchemaMigrator::migrate();
+        if (!migration.ok) {
+            qCritical() << "[Main] Schema migration failed:" << migration.error;
+        }
+    }
+
+    // 查询耗时统计：设置 RAINHUB_QUERY_METRICS=<报告文件路径> 时开启，每分钟写一次各 DAO 方法的耗时分布
+    const QString metricsPath = qEnvironmentVariable("RAINHUB_QUERY_METRICS");
+    if (!metricsPath.isEmpty()) {
+        QueryMetrics::setEnabled(true);
+        QueryMetrics::startPeriodicDump(metricsPath);
+        qDebug() << "[Main] Query metrics enabled, dumping to:" << metricsPath;
+    }
+
+    // 慢查询日志：设置 RAINHUB_SLOW_QUERY_MS=<阈值毫秒> 时开启，RAINHUB_SLOW_QUERY_LOG=<文件路径> 可额外写入文件
+    const int slowQueryMs = qEnvironmentVariableIntValue("RAINHUB_SLOW_QUERY_MS");
+    if (slowQueryMs > 0) {
+        SlowQueryConfig slowConfig;
+        slowConfig.thresholdMs = slowQueryMs;
+        slowConfig.logFile = qEnvironmentVariable("RAINHUB_SLOW_QUERY_LOG");
+        SlowQueryLog::configure(slowConfig);
+        qDebug() << "[Main] Slow query log enabled, threshold(ms):" << slowQueryMs;
+    }
+    
     MainWindow w;
     w.show();
     return app.exec();
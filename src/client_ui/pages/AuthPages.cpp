@@ -150,28 +150,31 @@ void UserInputPage::onSubmit()
         return;
     }
 
-    auto status = m_authService->checkLogin(userId, userName);
-
-    switch (status) {
-    case AuthService::LoginStatus::SuccessFirstTime:
-        emit firstLogin(userId, userName);
-        break;
-    case AuthService::LoginStatus::SuccessNormal:
-        emit normalLogin(userId, userName);
-        break;
-    case AuthService::LoginStatus::UserNotFound:
-        QMessageBox::warning(this, tr("用户不存在"), tr("未找到该学号/工号对应的用户，请检查输入。"));
-        break;
-    case AuthService::LoginStatus::NameMismatch:
-        QMessageBox::warning(this, tr("姓名不匹配"), tr("姓名与学号/工号不匹配，请检查输入。"));
-        break;
-    case AuthService::LoginStatus::DatabaseError:
-        QMessageBox::critical(this, tr("数据库错误"), tr("无法连接到数据库，请检查服务是否已启动。"));
-        break;
-    case AuthService::LoginStatus::AdminNotAllowed:
-        QMessageBox::warning(this, tr("权限错误"), tr("管理员账号请使用管理员后台登录，不能在客户端登录。"));
-        break;
-    }
+    if (m_pending) return;
+    m_pending = true;
+    m_authService->checkLoginAsync(userId, userName, this, [this, userId, userName](AuthService::LoginStatus status) {
+        m_pending = false;
+        switch (status) {
+        case AuthService::LoginStatus::SuccessFirstTime:
+            emit firstLogin(userId, userName);
+            break;
+        case AuthService::LoginStatus::SuccessNormal:
+            emit normalLogin(userId, userName);
+            break;
+        case AuthService::LoginStatus::UserNotFound:
+            QMessageBox::warning(this, tr("用户不存在"), tr("未找到该学号/工号对应的用户，请检查输入。"));
+            break;
+        case AuthService::LoginStatus::NameMismatch:
+            QMessageBox::warning(this, tr("姓名不匹配"), tr("姓名与学号/工号不匹配，请检查输入。"));
+            break;
+        case AuthService::LoginStatus::DatabaseError:
+            QMessageBox::critical(this, tr("数据库错误"), tr("无法连接到数据库，请检查服务是否已启动。"));
+            break;
+        case AuthService::LoginStatus::AdminNotAllowed:
+            QMessageBox::warning(this, tr("权限错误"), tr("管理员账号请使用管理员后台登录，不能在客户端登录。"));
+            break;
+        }
+    });
 }
 
 //FirstLoginPage实现
@@ -276,13 +279,18 @@ void FirstLoginPage::onSubmit()
         return;
     }
 
-    if (m_authService->activateUser(m_userId, m_userName, newPass)) {
-        clearInputs();
-        QMessageBox::information(this, tr("注册成功"), tr("密码设置成功！请使用新密码登录。"));
-        emit registerSuccess();
-    } else {
-        QMessageBox::critical(this, tr("设置失败"), tr("密码设置失败，请重试。"));
-    }
+    if (m_pending) return;
+    m_pending = true;
+    m_authService->activateUserAsync(m_userId, m_userName, newPass, this, [this](bool ok) {
+        m_pending = false;
+        if (ok) {
+            clearInputs();
+            QMessageBox::information(this, tr("注册成功"), tr("密码设置成功！请使用新密码登录。"));
+            emit registerSuccess();
+        } else {
+            QMessageBox::critical(this, tr("设置失败"), tr("密码设置失败，请重试。"));
+        }
+    });
 }
 
 //LoginPage实现
@@ -387,37 +395,50 @@ void LoginPage::onLogin()
         return;
     }
 
-    if (!m_authService->verifyPassword(m_userId, password)) {
-        QMessageBox::warning(this, tr("登录失败"), tr("密码错误，请检查输入。"));
-        return;
-    }
-
-    // 从数据库获取完整用户信息
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    UserDao userDao;
-    auto userOpt = userDao.selectById(db, m_userId);
-    
-    if (userOpt.has_value()) {
-        auto user = std::make_shared<User>(
-            userOpt->get_id(),
-            userOpt->get_name(),
-            userOpt->get_password(),
-            userOpt->get_role(),
-            userOpt->get_credit(),
-            userOpt->get_is_active()
-        );
-        
-        // 检查是否是管理员
-        if (user->get_role() == 9) {
-            QMessageBox::warning(this, tr("权限错误"), tr("管理员账号请使用管理员后台登录。"));
+    // 验证密码和读取用户信息都放到DB工作线程，登录期间界面保持响应
+    if (m_pending) return;
+    m_pending = true;
+    const QString userId = m_userId;
+    m_authService->verifyPasswordAsync(userId, password, this, [this, userId](bool ok) {
+        if (!ok) {
+            m_pending = false;
+            QMessageBox::warning(this, tr("登录失败"), tr("密码错误，请检查输入。"));
             return;
         }
-        
-        clearInputs();
-        emit loginSuccess(user);
-    } else {
-        QMessageBox::critical(this, tr("错误"), tr("获取用户信息失败"));
-    }
+
+        // 从数据库获取完整用户信息
+        DbExecutor::submit(this, [userId]() {
+            std::optional<User> userOpt;
+            if (auto lease = ConnectionPool::acquire()) {
+                UserDao userDao;
+                userOpt = userDao.selectById(*lease, userId);
+            }
+            return userOpt;
+        }, [this](std::optional<User> userOpt) {
+            m_pending = false;
+            if (userOpt.has_value()) {
+                auto user = std::make_shared<User>(
+                    userOpt->get_id(),
+                    userOpt->get_name(),
+                    userOpt->get_password(),
+                    userOpt->get_role(),
+                    userOpt->get_credit(),
+                    userOpt->get_is_active()
+                );
+                
+                // 检查是否是管理员
+                if (user->get_role() == 9) {
+                    QMessageBox::warning(this, tr("权限错误"), tr("管理员账号请使用管理员后台登录。"));
+                    return;
+                }
+                
+                clearInputs();
+                emit loginSuccess(user);
+            } else {
+                QMessageBox::critical(this, tr("错误"), tr("获取用户信息失败"));
+            }
+        });
+    });
 }
 
 void LoginPage::onForgotPassword()
@@ -528,19 +549,25 @@ void ResetPwdPage::onSubmit()
         return;
     }
 
-    // 先验证旧密码
-    if (!m_authService->verifyPassword(m_userId, oldPass)) {
-        QMessageBox::warning(this, tr("修改失败"), tr("旧密码错误，请重试。"));
-        return;
-    }
-
-    // 修改密码
-    if (m_authService->activateUser(m_userId, m_userName, newPass)) {
-        clearInputs();
-        QMessageBox::information(this, tr("修改成功"), tr("密码已成功修改，请使用新密码重新登录。"));
-        emit resetSuccess();
-    } else {
-        QMessageBox::critical(this, tr("修改失败"), tr("密码修改失败，请重试。"));
-    }
+    // 先验证旧密码，再修改密码，两步都在DB工作线程执行
+    if (m_pending) return;
+    m_pending = true;
+    m_authService->verifyPasswordAsync(m_userId, oldPass, this, [this, newPass](bool ok) {
+        if (!ok) {
+            m_pending = false;
+            QMessageBox::warning(this, tr("修改失败"), tr("旧密码错误，请重试。"));
+            return;
+        }
+        m_authService->activateUserAsync(m_userId, m_userName, newPass, this, [this](bool ok) {
+            m_pending = false;
+            if (ok) {
+                clearInputs();
+                QMessageBox::information(this, tr("修改成功"), tr("密码已成功修改，请使用新密码重新登录。"));
+                emit resetSuccess();
+            } else {
+                QMessageBox::critical(this, tr("修改失败"), tr("密码修改失败，请重试。"));
+            }
+        });
+    });
 }
 
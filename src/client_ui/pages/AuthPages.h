@@ -45,6 +45,7 @@ private:
     AuthService *m_authService;
     QLineEdit *m_inputUser;
     QLineEdit *m_inputName;
+    bool m_pending { false }; // 查询进行中，忽略重复提交
 };
 
 // 首次登录设置密码页
@@ -69,6 +70,7 @@ private:
     QLabel *m_userInfoLabel;
     QLineEdit *m_inputNewPass;
     QLineEdit *m_inputConfirmPass;
+    bool m_pending { false };
 };
 
 // 密码登录页
@@ -95,6 +97,7 @@ private:
     QString m_userName;
     QLabel *m_userInfoLabel;
     QLineEdit *m_inputPass;
+    bool m_pending { false };
 };
 
 //修改密码页
@@ -119,5 +122,6 @@ private:
     QLineEdit *m_inputOld;
     QLineEdit *m_inputNew;
     QLineEdit *m_inputConfirm;
+    bool m_pending { false };
 };
 
@@ -9,6 +9,7 @@
 #include "../../Model/RainGearFactory.h"
 #include "../../dao/RecordDao.h"
 #include "../../utils/ConnectionPool.h"
+#include "../../utils/StatementCache.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -17,7 +18,7 @@
 #include <QPushButton>
 #include <QMessageBox>
 #include <QTimer>
-#include <QApplication>
+#include <QUuid>
 
 BorrowPage::BorrowPage(BorrowService *borrowService, StationService *stationService, QWidget *parent)
     : QWidget(parent)
@@ -106,9 +107,20 @@ void BorrowPage::refreshSlots()
 {
     if (m_currentStationId == 0) return;
     
-    auto station = m_stationService->getStationDetail(static_cast<Station>(m_currentStationId));
-    if (!station) return;
-    
+    // 作废上一轮还没返回的刷新请求，避免旧数据覆盖新数据
+    m_refreshToken.cancel();
+    m_refreshToken = CancelToken();
+    const int stationId = m_currentStationId;
+    m_stationService->getStationDetailAsync(static_cast<Station>(stationId), this,
+        [this, stationId](std::unique_ptr<Stationlocal> station) {
+            if (station && stationId == m_currentStationId) {
+                applyStation(*station);
+            }
+        }, m_refreshToken);
+}
+
+void BorrowPage::applyStation(const Stationlocal &station)
+{
     // 固定雨具类型分配：1-4普通塑料伞，5-8高质量抗风伞，9-10专用遮阳伞，11-12雨衣
     static const QMap<int, QPair<GearType, QString>> slotTypeMap = {
         {1, {GearType::StandardPlastic, tr("普通塑料伞")}},
@@ -145,13 +157,13 @@ void BorrowPage::refreshSlots()
         }
         
         // 根据站点库存设置状态
-        if (station->is_gear_available(slotId)) {
+        if (station.is_gear_available(slotId)) {
             // 该槽位有雨具且可借
             slot->setState(SlotItem::State::Available);
-        } else if (station->is_slot_broken(slotId)) {
+        } else if (station.is_slot_broken(slotId)) {
             // 该槽位被标记为故障
             slot->setState(SlotItem::State::Maintenance);
-        } else if (station->has_gear(slotId)) {
+        } else if (station.has_gear(slotId)) {
             // 该槽位有雨具但不可借（已借出或其他原因）
             slot->setState(SlotItem::State::Maintenance);
         } else {
@@ -162,8 +174,6 @@ void BorrowPage::refreshSlots()
         slot->setEnabled(true);
         slot->repaint();
     }
-    
-    QApplication::processEvents();
 }
 
 void BorrowPage::startAutoRefresh()
@@ -187,6 +197,8 @@ void BorrowPage::onSlotClicked(int slotIndex)
         return;
     }
     
+    if (m_operationPending) return;
+    
     int slotId = slotIndex + 1;
     
     if (m_isBorrowMode) {
@@ -198,68 +210,115 @@ void BorrowPage::onSlotClicked(int slotIndex)
 
 void BorrowPage::handleBorrow(int slotId)
 {
-    // 获取站点详情（用于UI检查）
-    auto station = m_stationService->getStationDetail(static_cast<Station>(m_currentStationId));
-    if (!station) {
-        QMessageBox::warning(this, tr("错误"), tr("无法获取站点信息"));
-        return;
-    }
-    
-    // 检查槽位是否可借（UI层面的快速检查）
-    if (!station->is_gear_available(slotId)) {
+    // 检查槽位是否可借（UI层面的快速检查，用最近一次刷新的槽位状态，最终以Service层校验为准）
+    if (slotId < 1 || slotId > m_slots.size() || m_slots[slotId - 1]->state() != SlotItem::State::Available) {
         QMessageBox::warning(this, tr("提示"), tr("该槽位没有可借的雨具"));
         return;
     }
     
     // 直接调用借伞服务，传入站点ID和槽位ID
     // Service层会负责查找雨具ID并执行借伞逻辑
-    auto result = m_borrowService->borrowGear(
+    m_operationPending = true;
+    submitBorrow(slotId, QUuid::createUuid().toString(QUuid::WithoutBraces));
+}
+
+void BorrowPage::submitBorrow(int slotId, const QString &requestId, bool isRetry)
+{
+    m_borrowService->borrowGearAsync(
         m_currentUser->get_id(), 
         static_cast<Station>(m_currentStationId), 
-        slotId
+        slotId,
+        requestId,
+        isRetry,
+        this,
+        [this, slotId, requestId](ServiceResult result) {
+            if (result.success) {
+                m_operationPending = false;
+                QMessageBox::information(this, tr("借伞成功"), result.message);
+                refreshSlots();
+                emit operationCompleted();
+                return;
+            }
+            // 暂时性错误用同一个请求ID重试，上次其实已经成功时服务端直接返回上次的结果，不会重复借出
+            if (result.retryable
+                && QMessageBox::question(this, tr("借伞失败"), result.message + tr("\n是否重试？")) == QMessageBox::Yes) {
+                submitBorrow(slotId, requestId, true);
+                return;
+            }
+            m_operationPending = false;
+            QMessageBox::warning(this, tr("借伞失败"), result.message);
+        }
     );
-    
-    if (result.success) {
-        QMessageBox::information(this, tr("借伞成功"), result.message);
-        refreshSlots();
-        emit operationCompleted();
-    } else {
-        QMessageBox::warning(this, tr("借伞失败"), result.message);
-    }
 }
 
 void BorrowPage::handleReturn(int slotId)
 {
-    // 获取用户当前借出的雨具
-    auto db = ConnectionPool::getThreadLocalConnection();
-    RecordDao recordDao;
-    auto recordOpt = recordDao.selectUnfinishedByUserId(db, m_currentUser->get_id());
-    
-    if (!recordOpt.has_value()) {
-        QMessageBox::warning(this, tr("提示"), tr("您当前没有借出的雨具"));
-        return;
-    }
-    
-    QString gearId = recordOpt->get_gear_id();
-    
-    // 调用还伞服务
-    auto result = m_borrowService->returnGear(
+    // 先在DB工作线程查出用户当前借出的雨具，再调用还伞服务
+    m_operationPending = true;
+    const QString userId = m_currentUser->get_id();
+    const int stationId = m_currentStationId;
+    // 借不到连接或查询出错要和“没有未归还订单”分开，降级时不能告诉手里有伞的用户没借过
+    struct OpenRecord {
+        bool ok = false;
+        std::optional<BorrowRecord> record;
+    };
+    DbExecutor::submit(this, [userId]() {
+        // 租约只在查询期间持有，还伞服务会自己再借连接
+        OpenRecord result;
+        if (auto lease = ConnectionPool::acquire()) {
+            RecordDao recordDao;
+            result.record = recordDao.selectUnfinishedByUserId(*lease, userId);
+            result.ok = !StatementCache::lastError().isValid();
+        }
+        return result;
+    }, [this, userId, stationId, slotId](OpenRecord result) {
+        if (!result.ok) {
+            m_operationPending = false;
+            QMessageBox::warning(this, tr("提示"), tr("数据库连接失败，请稍后重试"));
+            return;
+        }
+        const std::optional<BorrowRecord>& recordOpt = result.record;
+        if (!recordOpt.has_value()) {
+            m_operationPending = false;
+            QMessageBox::warning(this, tr("提示"), tr("您当前没有借出的雨具"));
+            return;
+        }
+        
+        // 调用还伞服务
+        submitReturn(recordOpt->get_gear_id(), slotId, QUuid::createUuid().toString(QUuid::WithoutBraces));
+    });
+}
+
+void BorrowPage::submitReturn(const QString &gearId, int slotId, const QString &requestId, bool isRetry)
+{
+    m_borrowService->returnGearAsync(
         m_currentUser->get_id(), 
         gearId, 
         static_cast<Station>(m_currentStationId), 
-        slotId
-    );
-    
-    if (result.success) {
-        QString msg = result.message;
-        if (result.cost > 0) {
-            msg += tr("\n使用费用：%1 元").arg(result.cost);
+        slotId,
+        requestId,
+        isRetry,
+        this,
+        [this, gearId, slotId, requestId](ServiceResult result) {
+            if (result.success) {
+                m_operationPending = false;
+                QString msg = result.message;
+                if (result.cost > 0) {
+                    msg += tr("\n使用费用：%1 元").arg(result.cost);
+                }
+                QMessageBox::information(this, tr("还伞成功"), msg);
+                refreshSlots();
+                emit operationCompleted();
+                return;
+            }
+            // 重试时沿用已查出的雨具ID，不再查未归还订单（上次若已成功，订单已经结清）
+            if (result.retryable
+                && QMessageBox::question(this, tr("还伞失败"), result.message + tr("\n是否重试？")) == QMessageBox::Yes) {
+                submitReturn(gearId, slotId, requestId, true);
+                return;
+            }
+            m_operationPending = false;
+            QMessageBox::warning(this, tr("还伞失败"), result.message);
         }
-        QMessageBox::information(this, tr("还伞成功"), msg);
-        refreshSlots();
-        emit operationCompleted();
-    } else {
-        QMessageBox::warning(this, tr("还伞失败"), result.message);
-    }
+    );
 }
-
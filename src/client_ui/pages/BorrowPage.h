@@ -9,12 +9,14 @@
 #include <memory>
 #include "../../Model/User.h"
 #include "../../Model/GlobalEnum.hpp"
+#include "../../utils/DbExecutor.h"
 
 class QLabel;
 class QTimer;
 class SlotItem;
 class BorrowService;
 class StationService;
+class Stationlocal;
 
 class BorrowPage : public QWidget {
     Q_OBJECT
@@ -34,9 +36,13 @@ signals:
 
 private:
     void setupUi();
+    void applyStation(const Stationlocal &station);  // 用查询结果更新槽位显示
     void onSlotClicked(int slotIndex);
     void handleBorrow(int slotId);
     void handleReturn(int slotId);
+    // 提交借/还请求；requestId 每次操作生成一个，失败可重试时沿用同一个并带上 isRetry，服务端先查已记录的结果
+    void submitBorrow(int slotId, const QString &requestId, bool isRetry = false);
+    void submitReturn(const QString &gearId, int slotId, const QString &requestId, bool isRetry = false);
 
     BorrowService *m_borrowService;
     StationService *m_stationService;
@@ -48,5 +54,7 @@ private:
     QVector<SlotItem*> m_slots;
     QLabel *m_titleLabel;
     QTimer *m_refreshTimer;
+    CancelToken m_refreshToken;        // 当前这轮刷新请求的令牌
+    bool m_operationPending { false }; // 借还请求进行中，忽略重复点击
 };
 
@@ -149,7 +149,16 @@ void DashboardPage::refreshStations()
     m_stationComboBox->clear();
     m_stationComboBox->addItem(tr("-- 请选择站点 --"), 0);
     
-    auto stations = m_stationService->getAllStations();
+    // 站点列表在DB工作线程加载，返回后再填充下拉框
+    m_refreshToken.cancel();
+    m_refreshToken = CancelToken();
+    m_stationService->getAllStationsAsync(this, [this](std::vector<std::unique_ptr<Stationlocal>> stations) {
+        populateStations(stations);
+    }, m_refreshToken);
+}
+
+void DashboardPage::populateStations(const std::vector<std::unique_ptr<Stationlocal>> &stations)
+{
     for (size_t i = 0; i < stations.size(); ++i) {
         const auto &station = stations[i];
         if (station) {
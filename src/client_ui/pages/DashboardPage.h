@@ -6,12 +6,15 @@
 
 #include <QWidget>
 #include <memory>
+#include <vector>
 #include "../../Model/User.h"
 #include "../../Model/GlobalEnum.hpp"
+#include "../../utils/DbExecutor.h"
 
 class QComboBox;
 class QLabel;
 class StationService;
+class Stationlocal;
 
 class DashboardPage : public QWidget {
     Q_OBJECT
@@ -33,6 +36,7 @@ signals:
 private:
     void setupUi();
     void onStationChanged(int index);
+    void populateStations(const std::vector<std::unique_ptr<Stationlocal>> &stations); // 用加载结果填充站点下拉框
 
     StationService *m_stationService;
     std::shared_ptr<User> m_currentUser;
@@ -40,5 +44,6 @@ private:
     QComboBox *m_stationComboBox;
     QLabel *m_userInfoLabel;
     int m_currentStationId { 0 };
+    CancelToken m_refreshToken;  // 当前这轮站点加载请求的令牌
 };
 
@@ -75,6 +75,18 @@ void MapPage::refreshMap()
 }
 
 void MapPage::loadMapStations()
+{
+    if (!m_mapContainer) return;
+
+    // 动态数据（库存数量和在线状态）在DB工作线程查询，一次查询获取所有信息；作废上一轮还没返回的查询
+    m_refreshToken.cancel();
+    m_refreshToken = CancelToken();
+    m_stationService->getStationMapInfoAsync(this, [this](QMap<int, StationMapInfo> stationMapInfo) {
+        renderStations(stationMapInfo);
+    }, m_refreshToken);
+}
+
+void MapPage::renderStations(const QMap<int, StationMapInfo> &stationMapInfo)
 {
     if (!m_mapContainer) return;
     
@@ -86,12 +98,9 @@ void MapPage::loadMapStations()
     
     // 优化：分离静态数据和动态数据 
     
-    // 1. 从 JSON 读取静态配置（站点名称、坐标、描述）- 极快
+    // 从 JSON 读取静态配置（站点名称、坐标、描述）- 极快，动态数据由 loadMapStations() 查询后传入
     QMap<int, StationConfig> stationConfigs = MapConfigLoader::loadStationConfigs();
     
-    // 2. 从数据库读取动态数据（库存数量和在线状态）- 一次查询获取所有信息
-    QMap<int, StationMapInfo> stationMapInfo = m_stationService->getStationMapInfo();
-    
     // 计算容器尺寸
     int containerWidth = m_mapContainer->width();
     int containerHeight = m_mapContainer->height();
@@ -5,8 +5,11 @@
 #pragma once
 
 #include <QWidget>
+#include <QMap>
+#include "../../utils/DbExecutor.h"
 
 class StationService;
+struct StationMapInfo;
 
 class MapPage : public QWidget {
     Q_OBJECT
@@ -21,8 +24,10 @@ signals:
 private:
     void setupUi();
     void loadMapStations();
+    void renderStations(const QMap<int, StationMapInfo> &stationMapInfo);  // 用查询结果绘制站点
 
     StationService *m_stationService;
     QWidget *m_mapContainer;
+    CancelToken m_refreshToken;  // 当前这轮查询的令牌
 };
 
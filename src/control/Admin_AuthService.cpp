@@ -3,15 +3,18 @@
 */
 #include "Admin_AuthService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
 
 #include <QDebug>
 
 std::optional<User> Admin_AuthService::adminLogin(const QString& userId, const QString& password) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) {
+    QueryMetrics::Scope metricsScope("Admin_AuthService::adminLogin");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) {
         qCritical() << "[Admin_AuthService] 数据库连接失败";
         return std::nullopt;
     }
+    QSqlDatabase& db = *lease;
     
     auto userOpt = userDao.selectById(db, userId);
     if (!userOpt) { return std::nullopt;  }
@@ -20,3 +23,11 @@ std::optional<User> Admin_AuthService::adminLogin(const QString& userId, const Q
     
     return userOpt;
 }
+
+// 异步登录验证
+void Admin_AuthService::adminLoginAsync(const QString& userId, const QString& password, QObject* context,
+                                        std::function<void(std::optional<User>)> onDone) {
+    DbExecutor::submit(context, [this, userId, password]() {
+        return adminLogin(userId, password);
+    }, std::move(onDone));
+}
@@ -5,14 +5,19 @@
 
 #include <QString>
 #include <optional>
+#include <functional>
 
 #include "../dao/UserDao.h"
 #include "../model/User.h"
+#include "../utils/DbExecutor.h"
 
 class Admin_AuthService {
 public:
     // 管理员登录验证
     std::optional<User> adminLogin(const QString& userId, const QString& password);
+    // 异步登录验证，结果回到 context 所在线程
+    void adminLoginAsync(const QString& userId, const QString& password, QObject* context,
+                         std::function<void(std::optional<User>)> onDone);
 private:
     UserDao userDao;
 };
@@ -3,38 +3,216 @@
 */
 #include "Admin_GearService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
+#include "../utils/TransactionScope.h"
+#include "../Model/StationUtils.h"
 
-// 获取雨具列表（支持分页）
-QVector<GearInfoDTO> Admin_GearService::getAllGears(int stationId, int slotId, int limit, int offset) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
-    return gearDao.selectAllDTO(db, stationId, slotId, limit, offset);
+#include <QFile>
+#include <QTextStream>
+#include <QSet>
+#include <QDebug>
+
+// 获取一页雨具
+GearPage Admin_GearService::getGearPage(int stationId, int slotId, const QString& cursor, PageDirection direction, int limit) {
+    QueryMetrics::Scope metricsScope("Admin_GearService::getGearPage");
+    GearPage page;
+    // 列表里的 version 会被拿去做 CAS 更新，必须读主库，副本滞后会导致反复冲突
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return page;
+    QSqlDatabase& db = *lease;
+    bool hasMore = false;
+    page.gears = gearDao.selectPageDTO(db, stationId, slotId, cursor, direction, limit, &hasMore);
+    if (direction == PageDirection::Before) {
+        page.hasPrev = hasMore;
+        page.hasNext = true; // 是从后面一页翻回来的
+    } else {
+        page.hasPrev = !cursor.isEmpty();
+        page.hasNext = hasMore;
+    }
+    return page;
 }
 
 // 获取雨具总数（用于分页）
-int Admin_GearService::getGearCount(int stationId, int slotId) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return 0;
-    return gearDao.countGears(db, stationId, slotId);
+int Admin_GearService::getGearCount(int stationId, int slotId, bool allowCached) {
+    QueryMetrics::Scope metricsScope("Admin_GearService::getGearCount");
+    {
+        QMutexLocker locker(&countMutex);
+        if (allowCached && cachedAt.isValid() && cachedAt.elapsed() < COUNT_CACHE_MS
+            && cachedStationId == stationId && cachedSlotId == slotId) {
+            return cachedCount;
+        }
+    }
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return 0;
+    QSqlDatabase& db = *lease;
+    int count = gearDao.countGears(db, stationId, slotId);
+    
+    QMutexLocker locker(&countMutex);
+    cachedStationId = stationId;
+    cachedSlotId = slotId;
+    cachedCount = count;
+    cachedAt.start();
+    return count;
 }
 
 // 更新雨具状态
-bool Admin_GearService::updateGearStatus(const QString& gearId, int newStatus) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return false;
-    return gearDao.updateStatus(db, gearId, newStatus);
+WriteResult Admin_GearService::updateGearStatus(const QString& gearId, int newStatus, int expectedVersion) {
+    QueryMetrics::Scope metricsScope("Admin_GearService::updateGearStatus");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return WriteResult::Error;
+    QSqlDatabase& db = *lease;
+    return gearDao.updateStatus(db, gearId, newStatus, expectedVersion);
 }
 
 // 获取总借出数量
 int Admin_GearService::getTotalBorrowedCount() {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return 0;
+    QueryMetrics::Scope metricsScope("Admin_GearService::getTotalBorrowedCount");
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return 0;
+    QSqlDatabase& db = *lease;
     return gearDao.countByStatus(db, 2); //status=2是Borrowed
 }
 
 // 获取总故障数量
 int Admin_GearService::getTotalBrokenCount() {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return 0;
+    QueryMetrics::Scope metricsScope("Admin_GearService::getTotalBrokenCount");
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return 0;
+    QSqlDatabase& db = *lease;
     return gearDao.countByStatus(db, 3); //status=3是Broken
 }
+
+// 批量入库
+ProvisionReport Admin_GearService::provisionGears(const QVector<GearInfoDTO>& gears, int rowsPerTransaction) {
+    QueryMetrics::Scope metricsScope("Admin_GearService::provisionGears");
+    ProvisionReport report;
+    report.requested = gears.size();
+    QElapsedTimer timer;
+    timer.start();
+    auto addError = [&report](const QString& message) {
+        if (report.errors.size() < ProvisionReport::MAX_ERRORS) report.errors.append(message);
+    };
+
+    auto lease = ConnectionPool::acquire();
+    if (!lease) {
+        report.failed = report.requested;
+        addError(QStringLiteral("数据库连接不可用"));
+        return report;
+    }
+    QSqlDatabase& db = *lease;
+
+    bool ok = false;
+    QSet<QPair<int, int>> occupied = gearDao.selectOccupiedSlots(db, &ok);
+    if (!ok) {
+        report.failed = report.requested;
+        addError(QStringLiteral("读取槽位占用情况失败"));
+        return report;
+    }
+
+    // 内存校验，同一批内的编号和槽位也不能重复
+    const int maxStation = static_cast<int>(Station::Admin);
+    QVector<GearInfoDTO> valid;
+    valid.reserve(gears.size());
+    QSet<QString> seenIds;
+    seenIds.reserve(gears.size());
+    for (GearInfoDTO gear : gears) {
+        if (gear.status == 0) gear.status = static_cast<int>(GearStatus::Available);
+        QString problem;
+        if (gear.gearId.isEmpty() || gear.gearId.size() > 20) {
+            problem = QStringLiteral("雨具编号为空或超过20个字符");
+        } else if (seenIds.contains(gear.gearId)) {
+            problem = QStringLiteral("雨具编号在本批中重复");
+        } else if (gear.typeId < 1 || gear.typeId > 4) {
+            problem = QStringLiteral("未知的雨具类型 %1").arg(gear.typeId);
+        } else if (gear.status < 1 || gear.status > 3) {
+            problem = QStringLiteral("未知的雨具状态 %1").arg(gear.status);
+        } else if ((gear.stationId > 0) != (gear.slotId > 0)) {
+            problem = QStringLiteral("站点和槽位须同时填写或同时为 0");
+        } else if (gear.stationId < 0 || gear.stationId > maxStation) {
+            problem = QStringLiteral("未知的站点 %1").arg(gear.stationId);
+        } else if (gear.slotId > 0 && !StationUtils::isSlotForType(static_cast<GearType>(gear.typeId), gear.slotId)) {
+            problem = QStringLiteral("槽位 %1 不能放该类型的雨具").arg(gear.slotId);
+        } else if (gear.slotId > 0 && occupied.contains(qMakePair(gear.stationId, gear.slotId))) {
+            problem = QStringLiteral("站点 %1 的槽位 %2 已被占用").arg(gear.stationId).arg(gear.slotId);
+        }
+        if (!problem.isEmpty()) {
+            ++report.rejected;
+            addError(QStringLiteral("%1: %2").arg(gear.gearId, problem));
+            continue;
+        }
+        seenIds.insert(gear.gearId);
+        if (gear.slotId > 0) occupied.insert(qMakePair(gear.stationId, gear.slotId));
+        valid.append(gear);
+    }
+
+    // 分块写入，每块一个事务
+    const int chunkSize = qMax(GearDao::BATCH_INSERT_ROWS, rowsPerTransaction);
+    for (int begin = 0; begin < valid.size(); begin += chunkSize) {
+        const QVector<GearInfoDTO> chunk = valid.mid(begin, chunkSize);
+        auto txn = TransactionScope::run(db, [&](QSqlDatabase& db) {
+            return gearDao.insertBatch(db, chunk);
+        });
+        if (txn) {
+            report.inserted += chunk.size();
+        } else {
+            report.failed += chunk.size();
+            addError(QStringLiteral("第 %1-%2 行写入失败（可能是编号已存在）: %3")
+                         .arg(begin + 1).arg(begin + chunk.size()).arg(txn.error.text()));
+        }
+    }
+
+    report.elapsedMs = timer.elapsed();
+    qInfo() << "[Admin_GearService] 批量入库：提交" << report.requested << "条，写入" << report.inserted
+            << "条，校验跳过" << report.rejected << "条，写入失败" << report.failed << "条，耗时"
+            << report.elapsedMs << "ms，约" << qRound(report.rowsPerSecond()) << "条/秒";
+    return report;
+}
+
+// 异步批量入库
+void Admin_GearService::provisionGearsAsync(const QVector<GearInfoDTO>& gears, QObject* context,
+                                            std::function<void(ProvisionReport)> onDone) {
+    DbExecutor::submit(context, [this, gears]() {
+        return provisionGears(gears);
+    }, std::move(onDone));
+}
+
+// 解析批量入库文件
+QVector<GearInfoDTO> Admin_GearService::parseProvisionCsv(const QString& path, QStringList* errors) {
+    QVector<GearInfoDTO> gears;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errors) errors->append(QStringLiteral("无法打开文件 %1: %2").arg(path, file.errorString()));
+        return gears;
+    }
+    QTextStream in(&file);
+    int lineNo = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) continue;
+        const QStringList fields = line.split(QLatin1Char(','));
+        if (lineNo == 1 && fields.first().trimmed().compare(QStringLiteral("gear_id"), Qt::CaseInsensitive) == 0) continue; // 表头
+
+        bool ok = fields.size() == 4 || fields.size() == 5;
+        int values[4] = {0, 0, 0, static_cast<int>(GearStatus::Available)};
+        for (int i = 1; ok && i < fields.size(); ++i) {
+            values[i - 1] = fields[i].trimmed().toInt(&ok);
+        }
+        if (!ok) {
+            if (errors && errors->size() < ProvisionReport::MAX_ERRORS) {
+                errors->append(QStringLiteral("第 %1 行格式错误: %2").arg(lineNo).arg(line));
+            }
+            continue;
+        }
+        gears.append(GearInfoDTO{fields[0].trimmed(), values[0], values[1], values[2], values[3]});
+    }
+    return gears;
+}
+
+// 异步更新雨具状态
+void Admin_GearService::updateGearStatusAsync(const QString& gearId, int newStatus, int expectedVersion, QObject* context,
+                                              std::function<void(WriteResult)> onDone) {
+    DbExecutor::submit(context, [this, gearId, newStatus, expectedVersion]() {
+        return updateGearStatus(gearId, newStatus, expectedVersion);
+    }, std::move(onDone));
+}
@@ -5,17 +5,64 @@
 
 #include <QString>
 #include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <functional>
 #include "../dao/GearDao.h"
+#include "../utils/DbExecutor.h"
+
+// 雨具列表的一页结果
+struct GearPage {
+    QVector<GearInfoDTO> gears; // 按 gear_id 正序
+    bool hasPrev = false;       // 前面是否还有数据
+    bool hasNext = false;       // 后面是否还有数据
+    QString firstId() const { return gears.isEmpty() ? QString() : gears.first().gearId; } // 上一页的游标
+    QString lastId() const { return gears.isEmpty() ? QString() : gears.last().gearId; }   // 下一页的游标
+};
+
+// 批量入库结果
+struct ProvisionReport {
+    int requested = 0;      // 提交的行数
+    int inserted = 0;       // 成功写入的行数
+    int rejected = 0;       // 校验不通过而跳过的行数
+    int failed = 0;         // 所在事务写入失败而回滚的行数
+    QStringList errors;     // 前 MAX_ERRORS 条问题说明
+    qint64 elapsedMs = 0;   // 校验 + 写入总耗时
+    double rowsPerSecond() const { return elapsedMs > 0 ? inserted * 1000.0 / elapsedMs : inserted; }
+    static constexpr int MAX_ERRORS = 20;
+};
 
 class Admin_GearService {
 public:
-    // 获取雨具列表，分页查询
-    QVector<GearInfoDTO> getAllGears(int stationId = 0, int slotId = 0, int limit = 0, int offset = 0);
-    // 获取雨具总数（用于分页）
-    int getGearCount(int stationId = 0, int slotId = 0);
-    bool updateGearStatus(const QString& gearId, int newStatus); // 更新雨具状态
+    // 批量入库：先在内存中校验（编号、类型、站点、槽位与类型是否匹配、槽位是否已被占用），
+    // 通过的行按 rowsPerTransaction 分块，每块一个事务，块内用多行 INSERT 写入；某块失败只回滚该块
+    ProvisionReport provisionGears(const QVector<GearInfoDTO>& gears, int rowsPerTransaction = 5000);
+    void provisionGearsAsync(const QVector<GearInfoDTO>& gears, QObject* context,
+                             std::function<void(ProvisionReport)> onDone);
+    // 读取批量入库文件，每行 gear_id,type_id,station_id,slot_id[,status]，未入柜的雨具站点和槽位填 0；
+    // 可有表头行，格式错误的行跳过并记入 errors
+    static QVector<GearInfoDTO> parseProvisionCsv(const QString& path, QStringList* errors);
+
+    // 游标翻页获取雨具列表：cursor 为空时取第一页，下一页传 lastId()+After，上一页传 firstId()+Before
+    GearPage getGearPage(int stationId, int slotId, const QString& cursor, PageDirection direction, int limit);
+    // 获取雨具总数（用于分页显示）；allowCached 时同一筛选条件在 COUNT_CACHE_MS 内复用上次结果，不必每次全量计数
+    int getGearCount(int stationId = 0, int slotId = 0, bool allowCached = false);
+    // 更新雨具状态，expectedVersion 为列表中读到的版本号；期间被终端借走/归还过返回 Conflict，需刷新后重试
+    WriteResult updateGearStatus(const QString& gearId, int newStatus, int expectedVersion);
+    void updateGearStatusAsync(const QString& gearId, int newStatus, int expectedVersion, QObject* context,
+                               std::function<void(WriteResult)> onDone);
     int getTotalBorrowedCount(); // 获取总借出数量
     int getTotalBrokenCount(); // 获取总故障数量
 private:
+    static constexpr qint64 COUNT_CACHE_MS = 30000;
+
     GearDao gearDao;
-};
+    
+    // 最近一次计数结果
+    QMutex countMutex;
+    int cachedStationId = -1;
+    int cachedSlotId = -1;
+    int cachedCount = 0;
+    QElapsedTimer cachedAt;
+};
\ No newline at end of file
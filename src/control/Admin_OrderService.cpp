@@ -3,10 +3,89 @@
 */
 #include "Admin_OrderService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
 
-// 获取最近订单
-QVector<OrderInfo> Admin_OrderService::getRecentOrders(int limit) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
-    return recordDao.selectRecent(db, limit);
+#include <QSaveFile>
+#include <QTextStream>
+
+// 按条件查询订单
+OrderPage Admin_OrderService::queryOrders(const OrderFilter& filter, const OrderCursor& cursor, PageDirection direction, int limit) {
+    QueryMetrics::Scope metricsScope("Admin_OrderService::queryOrders");
+    OrderPage page;
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return page;
+    QSqlDatabase& db = *lease;
+    bool hasMore = false;
+    page.orders = recordDao.selectPageDTO(db, filter, cursor, direction, limit, &hasMore);
+    
+    // 本页涉及的用户和雨具各用一次批量查询取回，不再逐条查
+    QVector<QString> userIds;
+    QVector<QString> gearIds;
+    userIds.reserve(page.orders.size());
+    gearIds.reserve(page.orders.size());
+    for (const auto& order : page.orders) {
+        userIds.append(order.userId);
+        gearIds.append(order.gearId);
+    }
+    page.users = userDao.selectDTOByIds(db, userIds);
+    page.gears = gearDao.selectDTOByIds(db, gearIds);
+    if (direction == PageDirection::Before) {
+        page.hasPrev = hasMore;
+        page.hasNext = true; // 是从后面一页翻回来的
+    } else {
+        page.hasPrev = !cursor.isNull();
+        page.hasNext = hasMore;
+    }
+    return page;
+}
+
+// 导出订单为 CSV
+OrderExportResult Admin_OrderService::exportOrders(const OrderFilter& filter, const QString& path, const CancelToken& token) {
+    QueryMetrics::Scope metricsScope("Admin_OrderService::exportOrders");
+    OrderExportResult result;
+    QSaveFile file(path); // 写完才替换目标文件，中途失败不会留下半个文件
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        result.error = file.errorString();
+        return result;
+    }
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) {
+        result.error = QStringLiteral("数据库连接不可用");
+        return result;
+    }
+    QSqlDatabase& db = *lease;
+
+    QTextStream out(&file);
+    out << "record_id,user_id,gear_id,station_id,borrow_time,return_time,cost\n";
+    StreamResult stream = recordDao.streamDTO(db, filter, [&](const OrderInfoDTO& order) {
+        out << order.recordId << ',' << order.userId << ',' << order.gearId << ','
+            << order.stationId << ',' << order.borrowTime << ',' << order.returnTime << ','
+            << QString::number(order.cost, 'f', 2) << '\n';
+        return out.status() == QTextStream::Ok;
+    }, token);
+    out.flush();
+
+    result.rows = stream.rows;
+    if (stream.failed) {
+        result.error = QStringLiteral("读取订单失败");
+    } else if (out.status() != QTextStream::Ok) {
+        result.error = file.errorString();
+    } else if (stream.cancelled) {
+        result.cancelled = true;
+        file.cancelWriting(); // 取消时不替换目标文件
+    } else if (!file.commit()) {
+        result.error = file.errorString();
+    } else {
+        result.ok = true;
+    }
+    return result;
+}
+
+// 异步导出订单
+void Admin_OrderService::exportOrdersAsync(const OrderFilter& filter, const QString& path, QObject* context,
+                                           std::function<void(OrderExportResult)> onDone, CancelToken token) {
+    // 令牌只用来中止导出本身，取消后仍然回调，让界面知道导出已停止
+    DbExecutor::submit(context, [this, filter, path, token]() {
+        return exportOrders(filter, path, token);
+    }, std::move(onDone));
 }
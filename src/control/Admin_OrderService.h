@@ -5,14 +5,44 @@
 
 #include <QString>
 #include <QVector>
+#include <functional>
 #include "../dao/RecordDao.h"
+#include "../dao/UserDao.h"
+#include "../dao/GearDao.h"
+#include "../utils/DbExecutor.h"
 
 // 复用DAO层的DTO
 using OrderInfo = OrderInfoDTO;
 
+// 订单列表的一页结果
+struct OrderPage {
+    QVector<OrderInfo> orders; // 最新的在前
+    bool hasPrev = false;      // 前面（更新的订单）是否还有数据
+    bool hasNext = false;      // 后面（更早的订单）是否还有数据
+    QHash<QString, UserInfoDTO> users; // 本页订单涉及的用户，按 user_id
+    QHash<QString, GearInfoDTO> gears; // 本页订单涉及的雨具，按 gear_id
+    OrderCursor firstCursor() const { return orders.isEmpty() ? OrderCursor() : OrderCursor{orders.first().borrowTime, orders.first().recordId}; }
+    OrderCursor lastCursor() const { return orders.isEmpty() ? OrderCursor() : OrderCursor{orders.last().borrowTime, orders.last().recordId}; }
+};
+
+// 订单导出结果
+struct OrderExportResult {
+    bool ok = false;        // 全部写完
+    bool cancelled = false; // 中途被取消
+    qint64 rows = 0;        // 已写出的订单数
+    QString error;          // 失败原因
+};
+
 class Admin_OrderService {
 public:
-    QVector<OrderInfo> getRecentOrders(int limit = 50); // 获取最近订单
+    // 按条件把订单导出为 CSV：流式读取、边读边写，内存占用与订单总数无关；token 取消时停止且不生成文件
+    OrderExportResult exportOrders(const OrderFilter& filter, const QString& path, const CancelToken& token = CancelToken());
+    void exportOrdersAsync(const OrderFilter& filter, const QString& path, QObject* context,
+                           std::function<void(OrderExportResult)> onDone, CancelToken token = CancelToken());
+    // 按条件游标翻页查询订单：cursor 为空时取第一页（最新），下一页传 lastCursor()+After，上一页传 firstCursor()+Before
+    OrderPage queryOrders(const OrderFilter& filter, const OrderCursor& cursor, PageDirection direction, int limit);
 private:
     RecordDao recordDao;
+    UserDao userDao;
+    GearDao gearDao;
 };
@@ -3,24 +3,48 @@
 */
 #include "Admin_StationService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
 
 // 获取所有站点的统计信息
 QVector<StationStats> Admin_StationService::getStationStats() {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
+    QueryMetrics::Scope metricsScope("Admin_StationService::getStationStats");
+    // 结果里的 version 用于修改在线状态时的 CAS，读主库
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return {};
+    QSqlDatabase& db = *lease;
     return stationDao.selectAllWithStats(db);
 }
 
+// 异步获取所有站点的统计信息
+void Admin_StationService::getStationStatsAsync(QObject* context, std::function<void(QVector<StationStats>)> onDone,
+                                                CancelToken token) {
+    DbExecutor::submit(context, [this]() {
+        return getStationStats();
+    }, std::move(onDone), token);
+}
+
 // 获取设备在线率
 double Admin_StationService::getOnlineRate() {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return 0.0;
+    QueryMetrics::Scope metricsScope("Admin_StationService::getOnlineRate");
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return 0.0;
+    QSqlDatabase& db = *lease;
     return stationDao.getOnlineRate(db);
 }
 
 // 更新站点在线状态
-bool Admin_StationService::updateStationStatus(int stationId, bool isOnline) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return false;
-    return stationDao.updateStatus(db, stationId, isOnline);
-}
\ No newline at end of file
+WriteResult Admin_StationService::updateStationStatus(int stationId, bool isOnline, int expectedVersion) {
+    QueryMetrics::Scope metricsScope("Admin_StationService::updateStationStatus");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return WriteResult::Error;
+    QSqlDatabase& db = *lease;
+    return stationDao.updateStatus(db, stationId, isOnline, expectedVersion);
+}
+
+// 异步更新站点在线状态
+void Admin_StationService::updateStationStatusAsync(int stationId, bool isOnline, int expectedVersion, QObject* context,
+                                                    std::function<void(WriteResult)> onDone) {
+    DbExecutor::submit(context, [this, stationId, isOnline, expectedVersion]() {
+        return updateStationStatus(stationId, isOnline, expectedVersion);
+    }, std::move(onDone));
+}
@@ -5,7 +5,9 @@
 
 #include <QString>
 #include <QVector>
+#include <functional>
 #include "../dao/StationDao.h"
+#include "../utils/DbExecutor.h"
 
 // 复用DAO层的DTO
 using StationStats = StationStatsDTO;
@@ -13,8 +15,13 @@ using StationStats = StationStatsDTO;
 class Admin_StationService {
 public:
     QVector<StationStats> getStationStats(); // 获取所有站点的统计信息
+    void getStationStatsAsync(QObject* context, std::function<void(QVector<StationStats>)> onDone,
+                              CancelToken token = CancelToken()); // 异步获取站点统计，结果回到 context 所在线程
     double getOnlineRate(); // 获取设备在线率
-    bool updateStationStatus(int stationId, bool isOnline); // 更新站点在线状态
+    // 更新站点在线状态，expectedVersion 为列表中读到的版本号；期间被改过返回 Conflict，需刷新后重试
+    WriteResult updateStationStatus(int stationId, bool isOnline, int expectedVersion);
+    void updateStationStatusAsync(int stationId, bool isOnline, int expectedVersion, QObject* context,
+                                  std::function<void(WriteResult)> onDone);
 private:
     StationDao stationDao;
 };
@@ -3,31 +3,38 @@
 */
 #include "Admin_UserService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
 
 #include <QDebug>
 
-QVector<User> Admin_UserService::getAllUsers(const QString& searchText) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
-    QVector<User> allUsers = userDao.selectAll(db);
-    if (searchText.isEmpty()) { return allUsers;}
-    
-    // 按学号或姓名过滤搜索
-    QVector<User> filtered;
-    for (const auto& user : allUsers) {
-        if (user.get_id().contains(searchText, Qt::CaseInsensitive) ||
-            user.get_name().contains(searchText, Qt::CaseInsensitive)) {
-            filtered.append(user);
-        }
+UserPage Admin_UserService::searchUsers(const QString& searchText, int limit, int offset) {
+    QueryMetrics::Scope metricsScope("Admin_UserService::searchUsers");
+    UserPage page;
+    auto lease = ConnectionPool::acquire(DbAccess::ReadOnly);
+    if (!lease) return page;
+    QSqlDatabase& db = *lease;
+    // 过滤和分页都在数据库里完成，只传回当前页
+    page.totalCount = userDao.countSearch(db, searchText);
+    if (page.totalCount > offset) {
+        page.users = userDao.searchDTO(db, searchText, limit, offset);
     }
-    return filtered;
+    return page;
 }
 
 bool Admin_UserService::resetUserPassword(const QString& userId, const QString& newPassword) {
-    QSqlDatabase db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return false;
+    QueryMetrics::Scope metricsScope("Admin_UserService::resetUserPassword");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return false;
+    QSqlDatabase& db = *lease;
     // 先获取用户名
     auto userOpt = userDao.selectById(db, userId);
     if (!userOpt) return false;
     return userDao.updatePassword(db, userId, userOpt->get_name(), newPassword);
 }
+
+void Admin_UserService::resetUserPasswordAsync(const QString& userId, const QString& newPassword, QObject* context,
+                                               std::function<void(bool)> onDone) {
+    DbExecutor::submit(context, [this, userId, newPassword]() {
+        return resetUserPassword(userId, newPassword);
+    }, std::move(onDone));
+}
@@ -5,16 +5,26 @@
 
 #include <QString>
 #include <QVector>
+#include <functional>
 
 #include "../dao/UserDao.h"
 #include "../model/User.h"
+#include "../utils/DbExecutor.h"
+
+// 用户搜索的一页结果
+struct UserPage {
+    QVector<UserInfoDTO> users; // 当前页
+    int totalCount = 0;         // 满足条件的总数
+};
 
 class Admin_UserService {
 public:
-    // 获取所有用户,支持搜索
-    QVector<User> getAllUsers(const QString& searchText = "");
+    // 搜索用户并分页：按学号/工号或姓名前缀匹配，searchText 为空时列出全部
+    UserPage searchUsers(const QString& searchText, int limit, int offset = 0);
     // 重置用户密码
     bool resetUserPassword(const QString& userId, const QString& newPassword);
+    void resetUserPasswordAsync(const QString& userId, const QString& newPassword, QObject* context,
+                                std::function<void(bool)> onDone);
 
 private:
     UserDao userDao;
@@ -1,13 +1,17 @@
 #include"AuthService.h"
 #include"../utils/ConnectionPool.h"
+#include"../utils/QueryMetrics.h"
+#include"../utils/TransactionScope.h"
 #include<QDebug>
 
 AuthService::LoginStatus AuthService::checkLogin(const QString& id, const QString& name){
-    QSqlDatabase db=ConnectionPool::getThreadLocalConnection();
-    if(!db.isOpen()){
+    QueryMetrics::Scope metricsScope("AuthService::checkLogin");
+    auto lease=ConnectionPool::acquire();
+    if(!lease){
         qCritical() << "数据库连接失败";
         return LoginStatus::DatabaseError; 
     }
+    QSqlDatabase& db=*lease;
     auto user=userDao.selectById(db,id);
     if(!user){
         return LoginStatus::UserNotFound; // 学号不存在
@@ -21,12 +25,21 @@ AuthService::LoginStatus AuthService::checkLogin(const QString& id, const QStrin
     return LoginStatus::SuccessNormal; // 非首次login in，UI跳转输密码
 }
 
+void AuthService::checkLoginAsync(const QString& id, const QString& name, QObject* context,
+                                  std::function<void(LoginStatus)> onDone, CancelToken token){
+    DbExecutor::submit(context, [this, id, name](){
+        return checkLogin(id, name);
+    }, std::move(onDone), token);
+}
+
 bool AuthService::verifyPassword(const QString& id, const QString& password){
-    QSqlDatabase db=ConnectionPool::getThreadLocalConnection();
-    if(!db.isOpen()){
+    QueryMetrics::Scope metricsScope("AuthService::verifyPassword");
+    auto lease=ConnectionPool::acquire();
+    if(!lease){
         qCritical() << "数据库连接失败";
         return false;
     }
+    QSqlDatabase& db=*lease;
     auto user=userDao.selectById(db,id);
     if(!user){
         return false;
@@ -34,20 +47,30 @@ bool AuthService::verifyPassword(const QString& id, const QString& password){
     return user->get_password()==password;
 }
 
+void AuthService::verifyPasswordAsync(const QString& id, const QString& password, QObject* context,
+                                      std::function<void(bool)> onDone, CancelToken token){
+    DbExecutor::submit(context, [this, id, password](){
+        return verifyPassword(id, password);
+    }, std::move(onDone), token);
+}
+
 bool AuthService::activateUser(const QString& id, const QString& name, const QString& password){
-    QSqlDatabase db=ConnectionPool::getThreadLocalConnection();
-    if(!db.isOpen()){
+    QueryMetrics::Scope metricsScope("AuthService::activateUser");
+    auto lease=ConnectionPool::acquire();
+    if(!lease){
         qCritical() << "数据库连接失败";
         return false;
     }
-    if(!db.transaction()){
-        qCritical() << "数据库事务开启失败";
-        return false;
-    }
-    bool success=userDao.updatePassword(db,id,name,password);
-    if(!success){
-        db.rollback();
-        return false;
-    }
-    return db.commit();
-}
\ No newline at end of file
+    QSqlDatabase& db=*lease;
+    auto txn=TransactionScope::run(db,[&](QSqlDatabase& db){
+        return userDao.updatePassword(db,id,name,password);
+    });
+    return txn.committed;
+}
+
+void AuthService::activateUserAsync(const QString& id, const QString& name, const QString& password, QObject* context,
+                                    std::function<void(bool)> onDone, CancelToken token){
+    DbExecutor::submit(context, [this, id, name, password](){
+        return activateUser(id, name, password);
+    }, std::move(onDone), token);
+}
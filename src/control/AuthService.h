@@ -6,7 +6,9 @@
 
 #include<QString>
 #include<memory>
+#include<functional>
 #include"../dao/UserDao.h"
+#include"../utils/DbExecutor.h"
 
 class AuthService{
 public:
@@ -21,10 +23,19 @@ public:
     };
     // 登录检查,先判断账号密码是否合法
     LoginStatus checkLogin(const QString& id, const QString& name);
+    // 异步登录检查，结果回到 context 所在线程
+    void checkLoginAsync(const QString& id, const QString& name, QObject* context,
+                         std::function<void(LoginStatus)> onDone, CancelToken token = CancelToken());
     // 验证密码
     bool verifyPassword(const QString& id, const QString& password);
+    // 异步验证密码，结果回到 context 所在线程
+    void verifyPasswordAsync(const QString& id, const QString& password, QObject* context,
+                             std::function<void(bool)> onDone, CancelToken token = CancelToken());
     // 激活账户并设置密码
     bool activateUser(const QString& id, const QString& name, const QString& password);
+    // 异步激活账户/修改密码，结果回到 context 所在线程
+    void activateUserAsync(const QString& id, const QString& name, const QString& password, QObject* context,
+                           std::function<void(bool)> onDone, CancelToken token = CancelToken());
 private:
     UserDao userDao;
 };
@@ -1,126 +1,153 @@
 #include"BorrowService.h"
 #include"../utils/ConnectionPool.h"
-#include"../dao/StationDao.h"
+#include"../utils/QueryMetrics.h"
+#include"../utils/TransactionScope.h"
+#include"../utils/SqlDialect.h"
+#include"../Model/StationUtils.h"
 #include<QDebug>
 #include<QtMath>
+#include<atomic>
+
+// 借伞入口：重试时先查同一请求ID是否已经成功过，成功过直接返回记录的结果；
+// 执行失败时再查一次（与首次请求并发的情况），首次请求的成功路径上不多查
+ServiceResult BorrowService::borrowGear(const QString& userId, Station stationId, int slotId, const QString& requestId,
+                                        bool isRetry) {
+    QueryMetrics::Scope metricsScope("BorrowService::borrowGear");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return {false, "数据库连接失败", 0.0, true};
+    QSqlDatabase& db = *lease;
+    if (isRetry) {
+        if (auto previous = replay(db, requestId, userId, RequestKind::Borrow)) return *previous;
+    }
+
+    ServiceResult result = doBorrow(db, userId, stationId, slotId, requestId);
+    if (result.success) {
+        purgeExpiredRequests(db);
+        return result;
+    }
+    if (auto previous = replay(db, requestId, userId, RequestKind::Borrow)) return *previous;
+    return result;
+}
 
 // 借伞业务逻辑，传入用户ID、站点ID和槽位ID
-ServiceResult BorrowService::borrowGear(const QString& userId, Station stationId, int slotId) {
-    auto db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {false,"数据库连接失败"};
-
-    // 检查用户是否存在 & 激活
-    auto userBox=userDao.selectById(db, userId);
-    if (!userBox) return {false,"用户不存在"};
-    if (!userBox->get_is_active()) return {false, "账户未激活，请先去激活"};
-
-    // 检查用户是否已经借伞
-    auto unfinishedRecord = recordDao.selectUnfinishedByUserId(db, userId);
-    if (unfinishedRecord.has_value()) { return {false, "您有未归还的订单，请先归还后再借"}; }
-    
-    // 检查站点是否在线
-    StationDao stationDao;
-    auto station = stationDao.selectById(db, stationId);
-    if (!station) {
+// 事务外只做不加锁的预读；事务内第一步用条件 UPDATE 占用雨具，没抢到立即回滚，
+// 抢到后写订单，再用一条条件 UPDATE 扣押金并登记未归还订单，雨具行上的锁只持有这两条语句的时间。
+// “是否已有未归还订单”由最后这条 UPDATE 的条件保证，成功路径上不再单独查询，失败时回滚后再查原因
+ServiceResult BorrowService::doBorrow(QSqlDatabase& db, const QString& userId, Station stationId, int slotId,
+                                      const QString& requestId) {
+    const QString successMsg = QStringLiteral("借伞成功！请取走您的雨具");
+    // 检查站点是否在线、槽位是否故障（只读站点一行，短时缓存）
+    auto gate = stationDao.selectGateCached(db, stationId);
+    if (!gate) {
         return {false, "站点信息异常，请稍后重试"};
     }
-    if (!station->get_online()) {
+    if (!gate->isOnline) {
         return {false, "该站点当前离线，无法借伞，请选择其他站点"};
     }
+    if (gate->isSlotFaulty(slotId)) {
+        return {false, "该槽位故障，请选择其他槽位"};
+    }
     
-    // 根据站点和槽位查找雨具
+    // 预读槽位里的雨具，拿到雨具ID和押金；是否真的借得到以事务里的占用结果为准
     auto gear = gearDao.selectByStationAndSlot(db, stationId, slotId);
     if(!gear) return {false,"该槽位没有可借的雨具"};
-    
     QString gearId = gear->get_id();
-    
-    // 检查雨具状态（虽然查询时已经过滤了status=1，这里再确认一次）
-    if(gear->get_status()!= GearStatus::Available){ 
-        return {false,"该雨具已被借出或处于维护中"}; 
-    }
-    
-    // 检查余额是否足够支付押金
     double deposit=gear->get_deposit(); 
-    if (userBox->get_credit()<deposit){
-        return {false, QString("余额不足，当前雨具需押金 %1 元").arg(deposit)};
-    }
 
-    if (!db.transaction()) return {false, "事务开启失败"};
-    bool success = true;
-    if (!userDao.updateBalance(db, userId, -deposit)) {
-        qCritical() << "借伞失败：扣款步骤出错";
-        success = false;
-    }
+    // 占用雨具、写订单、扣押金放在同一个事务里，锁冲突时自动重试
+    bool claimed = false;
+    bool debited = false;
+    auto txn = TransactionScope::run(db, [&](QSqlDatabase& db) {
+        claimed = debited = false;
+        bool ok = false;
+        claimed = gearDao.claimForBorrow(db, gearId, stationId, slotId, &ok);
+        if (!claimed) {
+            if (!ok) qCritical() << "借伞失败：占用雨具出错";
+            return false;
+        }
+        // 插入借出记录 (Record)
+        qint64 recordId = recordDao.addBorrowRecord(db, userId, gearId, stationId);
+        if (recordId < 0) {
+            qCritical() << "借伞失败：创建订单记录出错";
+            return false;
+        }
+        // 用户不存在、未激活、已有未归还订单或余额不足时不生效，回滚后再查原因
+        debited = userDao.openBorrow(db, userId, recordId, deposit, &ok);
+        if (!debited) {
+            if (!ok) qCritical() << "借伞失败：扣款步骤出错";
+            return false;
+        }
+        // 同一请求ID已被并发的首次请求记录时主键冲突，回滚后按重放处理
+        return logRequest(db, requestId, userId, RequestKind::Borrow, successMsg, 0.0);
+    });
 
-    // 更新雨具状态为借出
-    Station originalStation = gear->get_station_id();
-    // 正常情况下，雨具应该有station_id。如果为Unknown，可能是数据异常，但不影响借伞流程
-    if (originalStation == Station::Unknown) {
-        qWarning() << "借伞警告：雨具" << gearId << "的station_id为Unknown，可能无法正确统计到站点";
-    }
-    
-    if (success && !gearDao.updateStatusAndLocation(db, gearId, GearStatus::Borrowed, originalStation, 0)) {
-        qCritical() << "借伞失败：更新雨具状态出错";
-        success = false;
+    if (!txn) {
+        if (txn.conflict) return {false, "当前借还人数较多，请稍后重试", 0.0, true};
+        // 用户ID不存在时写订单就会违反 record.user_id 外键，属于业务失败，交给下面查原因，不提示重试
+        if (txn.error.isValid() && !SqlDialect::isForeignKeyError(txn.error)) {
+            return {false, "系统内部错误，交易已取消", 0.0, true};
+        }
+        if (!claimed) return {false,"该雨具已被借出或处于维护中"};
+        if (!debited) {
+            auto userBox = userDao.selectById(db, userId);
+            if (!userBox) return {false,"用户不存在"};
+            if (!userBox->get_is_active()) return {false, "账户未激活，请先去激活"};
+            if (recordDao.selectUnfinishedByUserId(db, userId)) return {false, "您有未归还的订单，请先归还后再借"};
+            if (userBox->get_credit() < deposit) {
+                return {false, QString("余额不足，当前雨具需押金 %1 元").arg(deposit)};
+            }
+        }
+        return {false, "系统内部错误，交易已取消"};
     }
+    qInfo() <<"用户"<< userId <<"成功借出雨具"<<gearId << "（站点：" << static_cast<int>(stationId) << "，槽位：" << slotId << "）"
+            << "事务耗时" << txn.stats.elapsedMs << "ms";
+    return {true, successMsg};
+}
 
-    // 插入借出记录 (Record)
-    if (success && !recordDao.addBorrowRecord(db, userId, gearId)) {
-        qCritical() << "借伞失败：创建订单记录出错";
-        success = false;
+// 还伞入口：与借伞相同，重试时先按请求ID查是否已经还过，已还过则返回当时的费用
+ServiceResult BorrowService::returnGear(const QString& userId, const QString& gearId, Station stationId, int slotId,
+                                        const QString& requestId, bool isRetry) {
+    QueryMetrics::Scope metricsScope("BorrowService::returnGear");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return {false, "数据库连接失败", 0.0, true};
+    QSqlDatabase& db = *lease;
+    if (isRetry) {
+        if (auto previous = replay(db, requestId, userId, RequestKind::Return)) return *previous;
     }
 
-    if (success) {
-        db.commit(); 
-        qInfo() <<"用户"<< userId <<"成功借出雨具"<<gearId << "（站点：" << static_cast<int>(stationId) << "，槽位：" << slotId << "）";
-        return {true, "借伞成功！请取走您的雨具"};
-    } else {
-        db.rollback(); 
-        return {false, "系统内部错误，交易已取消"};
+    ServiceResult result = doReturn(db, userId, gearId, stationId, slotId, requestId);
+    if (result.success) {
+        purgeExpiredRequests(db);
+        return result;
     }
+    if (auto previous = replay(db, requestId, userId, RequestKind::Return)) return *previous;
+    return result;
 }
 
 // 还伞业务逻辑，传入用户ID和雨具ID，站点ID和槽位ID
-ServiceResult BorrowService::returnGear(const QString& userId, const QString& gearId, Station stationId, int slotId) {
-    auto db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {false, "数据库连接失败"};
-
+ServiceResult BorrowService::doReturn(QSqlDatabase& db, const QString& userId, const QString& gearId, Station stationId, int slotId,
+                                      const QString& requestId) {
     // 添加雨具对应槽位的判断
     auto gear = gearDao.selectById(db, gearId);
     if (!gear) return {false, "雨具信息异常(ID不存在)"};
 
-    // 检查站点是否在线
-    StationDao stationDao;
-    auto station = stationDao.selectById(db, stationId);
-    if (!station) {
+    // 检查站点是否在线、槽位是否故障（只读站点一行，短时缓存）
+    auto gate = stationDao.selectGateCached(db, stationId);
+    if (!gate) {
         return {false, "站点信息异常，请稍后重试"};
     }
-    if (!station->get_online()) {
+    if (!gate->isOnline) {
         return {false, "该站点当前离线，无法还伞，请选择其他站点"};
     }
+    if (gate->isSlotFaulty(slotId)) {
+        return {false, "该槽位故障，请更换槽位"};
+    }
 
     // 检查归还的槽位是否已经被占了
     if (gearDao.isSlotOccupied(db, stationId, slotId)) { return {false, "该槽位已有雨具，请更换槽位"}; }
 
-    bool isSlotValid = false;
-    GearType type = gear->get_type();
     // 根据雨具类型判断槽位是否合法
-    switch (type) {
-        case GearType::StandardPlastic:   //普通塑料伞: 1-4
-            if (slotId >= 1 && slotId <= 4) isSlotValid = true;
-            break;
-        case GearType::PremiumWindproof:  //高质量抗风伞: 5-8
-            if (slotId >= 5 && slotId <= 8) isSlotValid = true;
-            break;
-        case GearType::Sunshade:          //专用遮阳伞: 9-10
-            if (slotId >= 9 && slotId <= 10) isSlotValid = true;
-            break;
-        case GearType::Raincoat:          //雨衣: 11-12
-            if (slotId >= 11 && slotId <= 12) isSlotValid = true;
-            break;
-        default:
-            break;
-    }
+    bool isSlotValid = StationUtils::isSlotForType(gear->get_type(), slotId);
 
     if (!isSlotValid) {return {false, "归还位置错误！该类型雨具只能还到指定区域（请查看槽位说明）"};}
 
@@ -160,27 +187,85 @@ ServiceResult BorrowService::returnGear(const QString& userId, const QString& ge
                           gear->get_type() == GearType::Sunshade ? 1.5 : 2.0)
             << "计算费用=" << cost << "元";
     
-    if (!db.transaction()) return {false, "系统忙"};
-    bool success = true;
+    QString msg = QString("还伞成功！产生费用 %1 元，退回 %2 元").arg(cost, 0, 'f', 2).arg(refund, 0, 'f', 2);
+    bool gearChanged = false;
+    bool settled = false;
+    auto txn = TransactionScope::run(db, [&](QSqlDatabase& db) {
+        gearChanged = settled = false;
+        // 填入归还时间和费用
+        if (!recordDao.updateReturnInfo(db, recordBox->get_record_id(), returnTime, cost)) { return false; }
+        // 更新雨具状态为可用
+        // 按读取时的版本号更新，期间被管理端改过状态则冲突回滚，不覆盖对方的修改
+        WriteResult written = gearDao.updateStatusAndLocation(db, gearId, GearStatus::Available, stationId, slotId,
+                                                              gear->get_version());
+        if (written != WriteResult::Ok) {
+            gearChanged = written == WriteResult::Conflict;
+            return false;
+        }
+        // 退还押金 (扣除租金后的余额)并清空未归还订单指针；指针已不指向该订单说明别的请求已经结过账
+        bool ok = false;
+        if (!userDao.closeBorrow(db, userId, recordBox->get_record_id(), refund, &ok)) {
+            settled = ok;
+            return false;
+        }
+        return logRequest(db, requestId, userId, RequestKind::Return, msg, cost);
+    });
 
-    // 填入归还时间和费用
-    if (!recordDao.updateReturnInfo(db, recordBox->get_record_id(), returnTime, cost)) { success = false; }
-    
-    // 更新雨具状态为可用
-    if (success && !gearDao.updateStatusAndLocation(db, gearId, GearStatus::Available, stationId, slotId)) { success = false; }
-    
-    // 退还押金 (扣除租金后的余额)
-    if (success && !userDao.updateBalance(db, userId, refund)) { success = false; }
-
-    if (success) {
-        db.commit();
-        QString msg = QString("还伞成功！产生费用 %1 元，退回 %2 元").arg(cost, 0, 'f', 2).arg(refund, 0, 'f', 2);
-        qInfo() << msg;
-        return {true, msg, cost};
-    } else {
-        db.rollback();
-        return {false, "还伞失败，系统回滚"};
+    if (!txn) {
+        if (txn.conflict) return {false, "当前借还人数较多，请稍后重试", 0.0, true};
+        if (gearChanged) return {false, "雨具状态刚被修改，请重新放入后再试"};
+        if (settled) return {false, "该订单已结算，请勿重复还伞"};
+        return {false, "还伞失败，系统回滚", 0.0, txn.error.isValid()};
     }
+    qInfo() << msg << "事务耗时" << txn.stats.elapsedMs << "ms";
+    return {true, msg, cost};
+}
+
+// 查询同一请求是否已成功执行过；请求ID为空、未记录或已过保留期时返回空
+std::optional<ServiceResult> BorrowService::replay(QSqlDatabase& db, const QString& requestId, const QString& userId,
+                                                   RequestKind kind) {
+    if (requestId.isEmpty()) return std::nullopt;
+    QDateTime notBefore = QDateTime::currentDateTime().addSecs(-REQUEST_TTL_HOURS * 3600);
+    auto entry = requestLogDao.selectResult(db, requestId, userId, notBefore);
+    if (!entry || entry->kind != kind) return std::nullopt;
+    qInfo() << "请求" << requestId << "已执行过，返回首次结果";
+    return ServiceResult{true, entry->message, entry->cost};
+}
+
+// 在借还事务内记录成功的请求；请求ID为空时不记录
+bool BorrowService::logRequest(QSqlDatabase& db, const QString& requestId, const QString& userId, RequestKind kind,
+                               const QString& message, double cost) {
+    if (requestId.isEmpty()) return true;
+    return requestLogDao.insertResult(db, requestId, userId, RequestLogEntry{kind, message, cost});
+}
+
+// 借还成功后顺带清理过期记录，多个工作线程之间用原子变量避免同时清理
+void BorrowService::purgeExpiredRequests(QSqlDatabase& db) {
+    static std::atomic<qint64> lastPurgeMs{0};
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 last = lastPurgeMs.load();
+    if (now - last < 10 * 60 * 1000) return;
+    if (!lastPurgeMs.compare_exchange_strong(last, now)) return;
+    int removed = requestLogDao.purgeBefore(db, QDateTime::currentDateTime().addSecs(-REQUEST_TTL_HOURS * 3600));
+    if (removed > 0) qInfo() << "清理过期请求记录" << removed << "条";
+}
+
+// 异步借伞
+void BorrowService::borrowGearAsync(const QString& userId, Station stationId, int slotId, const QString& requestId,
+                                    bool isRetry, QObject* context, std::function<void(ServiceResult)> onDone,
+                                    CancelToken token) {
+    DbExecutor::submit(context, [this, userId, stationId, slotId, requestId, isRetry]() {
+        return borrowGear(userId, stationId, slotId, requestId, isRetry);
+    }, std::move(onDone), token);
+}
+
+// 异步还伞
+void BorrowService::returnGearAsync(const QString& userId, const QString& gearId, Station stationId, int slotId,
+                                    const QString& requestId, bool isRetry,
+                                    QObject* context, std::function<void(ServiceResult)> onDone, CancelToken token) {
+    DbExecutor::submit(context, [this, userId, gearId, stationId, slotId, requestId, isRetry]() {
+        return returnGear(userId, gearId, stationId, slotId, requestId, isRetry);
+    }, std::move(onDone), token);
 }
 
 // 辅助函数：计费规则
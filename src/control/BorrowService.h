@@ -3,30 +3,63 @@
 #include<QString>
 #include<QDateTime>
 #include<memory>
+#include<functional>
+#include<optional>
 
 #include"../dao/RecordDao.h"
 #include"../dao/GearDao.h"
 #include"../dao/UserDao.h"
+#include"../dao/StationDao.h"
+#include"../dao/RequestLogDao.h"
 #include"../model/GlobalEnum.hpp"
+#include"../utils/DbExecutor.h"
 
 // 给前端反馈借伞结果的结构体
 struct ServiceResult{
     bool success;
     QString message; // 提示信息
     double cost=0.0; // 费用
+    bool retryable=false; // 连接失败、锁冲突等暂时性错误，可用同一个请求ID重试
 };
 
+// requestId 为终端给每次借/还操作生成的唯一ID，重试时沿用同一个。
+// 成功的请求在同一事务里记入 request_log，同一ID的重试直接返回第一次的结果，不会重复借出或重复结算；
+// 为空时不做去重。终端重试时传 isRetry=true，先查 request_log，已成功过就直接返回记录的结果，不再执行借还；
+// 首次请求不多查这一次
 class BorrowService{
 public:
+    static constexpr int REQUEST_TTL_HOURS = 24; // 请求记录保留时长，超过后同一ID按新请求处理
+
     // 借伞（根据站点和槽位）
-    ServiceResult borrowGear(const QString& userId, Station stationId, int slotId);
+    ServiceResult borrowGear(const QString& userId, Station stationId, int slotId, const QString& requestId = QString(),
+                             bool isRetry = false);
     // 还伞
-    ServiceResult returnGear(const QString& userId, const QString& gearId, Station stationId, int slotId);
+    ServiceResult returnGear(const QString& userId, const QString& gearId, Station stationId, int slotId,
+                             const QString& requestId = QString(), bool isRetry = false);
+
+    // 异步接口：在DB工作线程执行，结果回到 context 所在线程调用 onDone
+    void borrowGearAsync(const QString& userId, Station stationId, int slotId, const QString& requestId, bool isRetry,
+                         QObject* context, std::function<void(ServiceResult)> onDone, CancelToken token = CancelToken());
+    void returnGearAsync(const QString& userId, const QString& gearId, Station stationId, int slotId, const QString& requestId,
+                         bool isRetry, QObject* context, std::function<void(ServiceResult)> onDone,
+                         CancelToken token = CancelToken());
 private:
+    ServiceResult doBorrow(QSqlDatabase& db, const QString& userId, Station stationId, int slotId, const QString& requestId);
+    ServiceResult doReturn(QSqlDatabase& db, const QString& userId, const QString& gearId, Station stationId, int slotId,
+                           const QString& requestId);
+    // 失败时查询同一请求是否已经成功过，是则返回当时的结果
+    std::optional<ServiceResult> replay(QSqlDatabase& db, const QString& requestId, const QString& userId, RequestKind kind);
+    // 在事务内记录成功的请求
+    bool logRequest(QSqlDatabase& db, const QString& requestId, const QString& userId, RequestKind kind,
+                    const QString& message, double cost);
+    // 清理过期的请求记录，同一进程内最多每 10 分钟执行一次
+    void purgeExpiredRequests(QSqlDatabase& db);
     // 计算费用
     double calculateCost(const QDateTime& borrowTime, const QDateTime& returnTime, GearType type);
     UserDao userDao;
     GearDao gearDao;
     RecordDao recordDao;
+    StationDao stationDao;
+    RequestLogDao requestLogDao;
 };
 
@@ -1,24 +1,55 @@
 #include "StationService.h"
 #include "../utils/ConnectionPool.h"
+#include "../utils/QueryMetrics.h"
 #include <QDebug>
 
 // 获取所有站点
 std::vector<std::unique_ptr<Stationlocal>> StationService::getAllStations() {
-    auto db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
+    QueryMetrics::Scope metricsScope("StationService::getAllStations");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return {};
+    QSqlDatabase& db = *lease;
     return stationDao.selectAll(db);
 }
 
 // 获取单个站点
 std::unique_ptr<Stationlocal> StationService::getStationDetail(Station stationId) {
-    auto db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return nullptr;
+    QueryMetrics::Scope metricsScope("StationService::getStationDetail");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return nullptr;
+    QSqlDatabase& db = *lease;
     return stationDao.selectById(db, stationId);
 }
 
 // 获取各站点的地图信息（库存数量和在线状态）
 QMap<int, StationMapInfo> StationService::getStationMapInfo() {
-    auto db = ConnectionPool::getThreadLocalConnection();
-    if (!db.isOpen()) return {};
+    QueryMetrics::Scope metricsScope("StationService::getStationMapInfo");
+    auto lease = ConnectionPool::acquire();
+    if (!lease) return {};
+    QSqlDatabase& db = *lease;
     return stationDao.selectStationMapInfo(db);
-}
\ No newline at end of file
+}
+
+// 异步获取所有站点
+void StationService::getAllStationsAsync(QObject* context, std::function<void(std::vector<std::unique_ptr<Stationlocal>>)> onDone,
+                                         CancelToken token) {
+    DbExecutor::submit(context, [this]() {
+        return getAllStations();
+    }, std::move(onDone), token);
+}
+
+// 异步获取单个站点
+void StationService::getStationDetailAsync(Station stationId, QObject* context, std::function<void(std::unique_ptr<Stationlocal>)> onDone,
+                                           CancelToken token) {
+    DbExecutor::submit(context, [this, stationId]() {
+        return getStationDetail(stationId);
+    }, std::move(onDone), token);
+}
+
+// 异步获取地图信息
+void StationService::getStationMapInfoAsync(QObject* context, std::function<void(QMap<int, StationMapInfo>)> onDone,
+                                            CancelToken token) {
+    DbExecutor::submit(context, [this]() {
+        return getStationMapInfo();
+    }, std::move(onDone), token);
+}
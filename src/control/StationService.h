@@ -3,8 +3,10 @@
 #include<vector>
 #include<memory>
 #include<QMap>
+#include<functional>
 #include"../dao/StationDao.h"
 #include"../model/Stationlocal.h"
+#include"../utils/DbExecutor.h"
 
 class StationService {
 public:
@@ -14,6 +16,14 @@ public:
     std::unique_ptr<Stationlocal> getStationDetail(Station stationId);
     // 获取各站点的地图信息（库存数量和在线状态，用于地图显示）
     QMap<int, StationMapInfo> getStationMapInfo();
+
+    // 异步接口：在DB工作线程执行，结果回到 context 所在线程调用 onDone
+    void getAllStationsAsync(QObject* context, std::function<void(std::vector<std::unique_ptr<Stationlocal>>)> onDone,
+                             CancelToken token = CancelToken());
+    void getStationDetailAsync(Station stationId, QObject* context, std::function<void(std::unique_ptr<Stationlocal>)> onDone,
+                               CancelToken token = CancelToken());
+    void getStationMapInfoAsync(QObject* context, std::function<void(QMap<int, StationMapInfo>)> onDone,
+                                CancelToken token = CancelToken());
     
 private:
     StationDao stationDao;
@@ -1,54 +1,44 @@
 #include"GearDao.h"
-#include"../Model/RainGearFactory.h"
+#include"RowMapper.h"
+#include"../utils/StatementCache.h"
+#include"../utils/QueryMetrics.h"
 
 #include<QSqlQuery>
 #include<QSqlError>
 #include<QDebug>
 #include<QVariant>
 #include<QStringList>
+#include<algorithm>
 
 // select_by_id
 std::unique_ptr<RainGear> GearDao::selectById(QSqlDatabase& db, const QString& id){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT * FROM raingear WHERE gear_id = ?"));
+    QueryMetrics::Scope metricsScope("GearDao::selectById");
+    static const QString sql = RowMapper<RainGear>::select(QStringLiteral("WHERE gear_id = ?"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(id);
-    if(!query.exec()){ return nullptr; }
+    if(!StatementCache::exec(query)){ return nullptr; }
 
     if(query.next()){
-        QString gearId = query.value("gear_id").toString();
-        GearType type = static_cast<GearType>(query.value("type_id").toInt());
-        
-        auto gear = RainGearFactory::create_raingear(type, gearId);
-        
-        if(gear){
-            gear->set_status(static_cast<GearStatus>(query.value("status").toInt()));
-            gear->set_station_id(static_cast<Station>(query.value("station_id").toInt()));
-            gear->set_slot_id(query.value("slot_id").toInt());
-        }
-        return gear;
+        return RowMapper<RainGear>::read(query);
     }
     return nullptr;
 }
 
 // select_by_station
 std::vector<std::unique_ptr<RainGear>> GearDao::selectByStation(QSqlDatabase& db, Station station){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT * FROM raingear WHERE station_id = ?"));
+    QueryMetrics::Scope metricsScope("GearDao::selectByStation");
+    static const QString sql = RowMapper<RainGear>::select(QStringLiteral("WHERE station_id = ?"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(static_cast<int>(station));
-    if(!query.exec()){ return std::vector<std::unique_ptr<RainGear>>(); }
+    if(!StatementCache::exec(query)){ return std::vector<std::unique_ptr<RainGear>>(); }
 
     std::vector<std::unique_ptr<RainGear>> gears;
     gears.reserve(16);
     while(query.next()){
-        QString gearId = query.value("gear_id").toString();
-        GearType type = static_cast<GearType>(query.value("type_id").toInt());
-
-        auto gear = RainGearFactory::create_raingear(type, gearId);
-        
+        auto gear = RowMapper<RainGear>::read(query);
         if (gear) {
-            gear->set_status(static_cast<GearStatus>(query.value("status").toInt()));
-            gear->set_station_id(static_cast<Station>(query.value("station_id").toInt()));
-            gear->set_slot_id(query.value("slot_id").toInt());            
             gears.push_back(std::move(gear));
         }
     }
@@ -57,39 +47,33 @@ std::vector<std::unique_ptr<RainGear>> GearDao::selectByStation(QSqlDatabase& db
 
 // 根据站点和槽位查询雨具（用于借伞时查找）
 std::unique_ptr<RainGear> GearDao::selectByStationAndSlot(QSqlDatabase& db, Station station, int slotId) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT * FROM raingear WHERE station_id = ? AND slot_id = ? AND status = 1 LIMIT 1"));
+    QueryMetrics::Scope metricsScope("GearDao::selectByStationAndSlot");
+    static const QString sql = RowMapper<RainGear>::select(QStringLiteral("WHERE station_id = ? AND slot_id = ? AND status = 1 LIMIT 1"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(static_cast<int>(station));
     query.addBindValue(slotId);
     
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "查询雨具失败:" << query.lastError().text();
         return nullptr;
     }
     
     if (query.next()) {
-        QString gearId = query.value("gear_id").toString();
-        GearType type = static_cast<GearType>(query.value("type_id").toInt());
-        
-        auto gear = RainGearFactory::create_raingear(type, gearId);
-        if (gear) {
-            gear->set_status(static_cast<GearStatus>(query.value("status").toInt()));
-            gear->set_station_id(static_cast<Station>(query.value("station_id").toInt()));
-            gear->set_slot_id(query.value("slot_id").toInt());
-            return gear;
-        }
+        return RowMapper<RainGear>::read(query);
     }
     return nullptr;
 }
 
 // check_slot_occupied
 bool GearDao::isSlotOccupied(QSqlDatabase& db, Station station, int slot_id){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT count(*) FROM raingear WHERE station_id = ? AND slot_id = ?"));
+    QueryMetrics::Scope metricsScope("GearDao::isSlotOccupied");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("SELECT count(*) FROM raingear WHERE station_id = ? AND slot_id = ?"));
+    QSqlQuery& query = *statement;
     query.addBindValue(static_cast<int>(station));
     query.addBindValue(slot_id);
     
-    if(!query.exec()){ return false; }
+    if(!StatementCache::exec(query)){ return false; }
     if(query.next()){
         return query.value(0).toInt() > 0;
     }
@@ -98,120 +82,207 @@ bool GearDao::isSlotOccupied(QSqlDatabase& db, Station station, int slot_id){
 
 // insert
 bool GearDao::insert(QSqlDatabase& db, const QString& gearId, GearType type, Station stationId, int slotId){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("INSERT INTO raingear (gear_id, type_id, station_id, slot_id, status) VALUES (?, ?, ?, ?, 1)"));
+    QueryMetrics::Scope metricsScope("GearDao::insert");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("INSERT INTO raingear (gear_id, type_id, station_id, slot_id, status) VALUES (?, ?, ?, ?, 1)"));
+    QSqlQuery& query = *statement;
     query.addBindValue(gearId);
     query.addBindValue(static_cast<int>(type));
     query.addBindValue(static_cast<int>(stationId));
     query.addBindValue(slotId);
-    return query.exec();
+    return StatementCache::exec(query);
+}
+
+// 批量插入
+bool GearDao::insertBatch(QSqlDatabase& db, const QVector<GearInfoDTO>& gears){
+    QueryMetrics::Scope metricsScope("GearDao::insertBatch");
+    // 满批次的语句文本固定，走语句缓存只 prepare 一次；最后不足一批的那条每次行数不同，
+    // 单独拼、用完即弃，不进缓存，免得把热点 DAO 语句挤出 LRU
+    auto buildSql = [](int rows){
+        QString sql = QStringLiteral("INSERT INTO raingear (gear_id, type_id, station_id, slot_id, status) VALUES ");
+        sql.reserve(sql.size() + rows * 18);
+        for(int i = 0; i < rows; ++i){
+            sql += i == 0 ? QStringLiteral("(?, ?, ?, ?, ?)") : QStringLiteral(", (?, ?, ?, ?, ?)");
+        }
+        return sql;
+    };
+    static const QString fullBatchSql = buildSql(BATCH_INSERT_ROWS);
+
+    for(int begin = 0; begin < gears.size(); begin += BATCH_INSERT_ROWS){
+        const int rows = qMin(BATCH_INSERT_ROWS, static_cast<int>(gears.size()) - begin);
+        CachedQuery statement;
+        if(rows == BATCH_INSERT_ROWS){
+            statement = StatementCache::prepare(db, fullBatchSql);
+        }else{
+            statement = CachedQuery(std::make_shared<QSqlQuery>(db));
+            statement->prepare(buildSql(rows));
+        }
+        QSqlQuery& query = *statement;
+        for(int i = begin; i < begin + rows; ++i){
+            const GearInfoDTO& gear = gears[i];
+            query.addBindValue(gear.gearId);
+            query.addBindValue(gear.typeId);
+            query.addBindValue(gear.stationId > 0 ? QVariant(gear.stationId) : QVariant());
+            query.addBindValue(gear.slotId > 0 ? QVariant(gear.slotId) : QVariant());
+            query.addBindValue(gear.status);
+        }
+        if(!StatementCache::exec(query)){
+            qCritical() << "[GearDao::insertBatch] Error:" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+// 查询被占用的槽位（每个站点最多12个，数据量很小）
+QSet<QPair<int, int>> GearDao::selectOccupiedSlots(QSqlDatabase& db, bool* ok){
+    QueryMetrics::Scope metricsScope("GearDao::selectOccupiedSlots");
+    QSet<QPair<int, int>> occupied;
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("SELECT station_id, slot_id FROM raingear WHERE station_id IS NOT NULL AND slot_id IS NOT NULL"));
+    QSqlQuery& query = *statement;
+    const bool success = StatementCache::exec(query);
+    if(ok){ *ok = success; }
+    if(!success){ return occupied; }
+    while(query.next()){
+        occupied.insert(qMakePair(query.value(0).toInt(), query.value(1).toInt()));
+    }
+    return occupied;
 }
 
 // delete_by_id
 bool GearDao::deleteById(QSqlDatabase& db, const QString& id){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("DELETE FROM raingear WHERE gear_id = ?"));
+    QueryMetrics::Scope metricsScope("GearDao::deleteById");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("DELETE FROM raingear WHERE gear_id = ?"));
+    QSqlQuery& query = *statement;
     query.addBindValue(id);
-    return query.exec();
+    return StatementCache::exec(query);
 }
 
 // update_status_and_location
 // 当station=Station::Unknown 时，station_id 设为 NULL（表示雨具被借走，不在任何站点）
-bool GearDao::updateStatusAndLocation(QSqlDatabase& db, const QString& id, GearStatus status, Station station, int slot_id){
-    QSqlQuery query(db);
+WriteResult GearDao::updateStatusAndLocation(QSqlDatabase& db, const QString& id, GearStatus status, Station station, int slot_id,
+                                             int expectedVersion){
+    QueryMetrics::Scope metricsScope("GearDao::updateStatusAndLocation");
+    // 借出状态：station_id 和 slot_id 设为 NULL；归还状态：正常设置 station_id 和 slot_id
+    // slot_id <= 0 表示不在槽位上，存为 NULL，不占 (station_id, slot_id) 唯一索引
+    CachedQuery statement = StatementCache::prepare(db, station == Station::Unknown
+        ? QStringLiteral("UPDATE raingear SET status = ?, station_id = NULL, slot_id = NULL, version = version + 1 WHERE gear_id = ? AND version = ?")
+        : QStringLiteral("UPDATE raingear SET status = ?, station_id = ?, slot_id = ?, version = version + 1 WHERE gear_id = ? AND version = ?"));
+    QSqlQuery& query = *statement;
     
     if (station == Station::Unknown) {
-        // 借出状态：station_id 和 slot_id 设为 NULL
-        query.prepare(QStringLiteral("UPDATE raingear SET status = ?, station_id = NULL, slot_id = NULL WHERE gear_id = ?"));
         query.addBindValue(static_cast<int>(status));
         query.addBindValue(id);
     } else {
-        // 归还状态：正常设置 station_id 和 slot_id
-        query.prepare(QStringLiteral("UPDATE raingear SET status = ?, station_id = ?, slot_id = ? WHERE gear_id = ?"));
         query.addBindValue(static_cast<int>(status));
         query.addBindValue(static_cast<int>(station)); 
-        query.addBindValue(slot_id);
+        query.addBindValue(slot_id > 0 ? QVariant(slot_id) : QVariant());
         query.addBindValue(id);
     }
+    query.addBindValue(expectedVersion);
     
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "[GearDao::updateStatusAndLocation] Error:" << query.lastError().text();
-        return false;
+        return WriteResult::Error;
     }
-    return true;
+    if (query.numRowsAffected() == 0) {
+        qWarning() << "[GearDao::updateStatusAndLocation] 版本冲突:" << id << "version" << expectedVersion;
+        return WriteResult::Conflict;
+    }
+    return WriteResult::Ok;
 }
 
 // 仅更新状态
-bool GearDao::updateStatus(QSqlDatabase& db, const QString& id, int status) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("UPDATE raingear SET status = ? WHERE gear_id = ?"));
+WriteResult GearDao::updateStatus(QSqlDatabase& db, const QString& id, int status, int expectedVersion) {
+    QueryMetrics::Scope metricsScope("GearDao::updateStatus");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "UPDATE raingear SET status = ?, version = version + 1 WHERE gear_id = ? AND version = ?"));
+    QSqlQuery& query = *statement;
     query.addBindValue(status);
     query.addBindValue(id);
-    return query.exec();
+    query.addBindValue(expectedVersion);
+    if (!StatementCache::exec(query)) {
+        qCritical() << "[GearDao::updateStatus] Error:" << query.lastError().text();
+        return WriteResult::Error;
+    }
+    return query.numRowsAffected() == 0 ? WriteResult::Conflict : WriteResult::Ok;
+}
+
+// 借伞时占用雨具
+// 条件里带上预读到的 gear_id，槽位里中途换了一把（押金不同）也算没抢到
+bool GearDao::claimForBorrow(QSqlDatabase& db, const QString& gearId, Station station, int slotId, bool* ok) {
+    QueryMetrics::Scope metricsScope("GearDao::claimForBorrow");
+    if (ok) *ok = false;
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "UPDATE raingear SET status = 2, slot_id = NULL, version = version + 1 WHERE gear_id = ? AND station_id = ? AND slot_id = ? AND status = 1"));
+    QSqlQuery& query = *statement;
+    query.addBindValue(gearId);
+    query.addBindValue(static_cast<int>(station));
+    query.addBindValue(slotId);
+    if (!StatementCache::exec(query)) {
+        qCritical() << "[GearDao::claimForBorrow] Error:" << query.lastError().text();
+        return false;
+    }
+    if (ok) *ok = true;
+    return query.numRowsAffected() == 1;
 }
 
 
 
 // 管理员后台Part
-// 获取雨具DTO列表（支持分页）
-QVector<GearInfoDTO> GearDao::selectAllDTO(QSqlDatabase& db, int stationId, int slotId, int limit, int offset) {
+// 按游标获取一页雨具DTO
+QVector<GearInfoDTO> GearDao::selectPageDTO(QSqlDatabase& db, int stationId, int slotId, const QString& cursor,
+                                           PageDirection direction, int limit, bool* hasMore) {
+    QueryMetrics::Scope metricsScope("GearDao::selectPageDTO");
     QVector<GearInfoDTO> result;
-    QString sql = "SELECT gear_id, type_id, station_id, slot_id, status FROM raingear";
+    const bool backward = direction == PageDirection::Before;
     QStringList conditions;
     if (stationId > 0) { conditions.append("station_id = :station_id"); }
     if (slotId > 0) { conditions.append("slot_id = :slot_id"); }
-    if (!conditions.isEmpty()) { sql += " WHERE " + conditions.join(" AND "); }
-    sql += " ORDER BY gear_id";
-    
-    // 添加分页限制
-    if (limit > 0) {
-        sql += " LIMIT :limit";
-        if (offset > 0) {
-            sql += " OFFSET :offset";
-        }
+    if (!cursor.isEmpty()) {
+        conditions.append(backward ? "gear_id < :cursor"
+                          : direction == PageDirection::AtOrAfter ? "gear_id >= :cursor" : "gear_id > :cursor");
     }
+    // 上一页倒序取紧挨着游标的那些行，取回后再翻转成正序
+    QString sql = RowMapper<GearInfoDTO>::select(conditions.isEmpty() ? QString() : "WHERE " + conditions.join(" AND "));
+    sql += backward ? " ORDER BY gear_id DESC LIMIT :limit" : " ORDER BY gear_id LIMIT :limit";
     
-    QSqlQuery query(db);
-    query.prepare(sql);
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     if (stationId > 0) { query.bindValue(":station_id", stationId); }
     if (slotId > 0) { query.bindValue(":slot_id", slotId); }
-    if (limit > 0) {
-        query.bindValue(":limit", limit);
-        if (offset > 0) {
-            query.bindValue(":offset", offset);
-        }
-    }
+    if (!cursor.isEmpty()) { query.bindValue(":cursor", cursor); }
+    query.bindValue(":limit", limit + 1);
     
-    if (!query.exec()) { 
+    if (!StatementCache::exec(query)) { 
         qCritical() << "查询雨具列表失败:" << query.lastError().text();
+        if (hasMore) { *hasMore = false; }
         return result; 
     }
-    while (query.next()) {
-        result.append(GearInfoDTO{
-            query.value("gear_id").toString(),
-            query.value("type_id").toInt(),
-            query.value("station_id").toInt(),
-            query.value("slot_id").toInt(),
-            query.value("status").toInt()
-        });
-    }
+    result.reserve(limit + 1);
+    RowMapper<GearInfoDTO>::readAll(query, result);
+    
+    const bool more = result.size() > limit;
+    if (more) { result.removeLast(); }
+    if (backward) { std::reverse(result.begin(), result.end()); }
+    if (hasMore) { *hasMore = more; }
     return result;
 }
 
 // 统计雨具总数（用于分页计算）
 int GearDao::countGears(QSqlDatabase& db, int stationId, int slotId) {
+    QueryMetrics::Scope metricsScope("GearDao::countGears");
     QString sql = "SELECT COUNT(*) FROM raingear";
     QStringList conditions;
     if (stationId > 0) { conditions.append("station_id = :station_id"); }
     if (slotId > 0) { conditions.append("slot_id = :slot_id"); }
     if (!conditions.isEmpty()) { sql += " WHERE " + conditions.join(" AND "); }
     
-    QSqlQuery query(db);
-    query.prepare(sql);
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     if (stationId > 0) { query.bindValue(":station_id", stationId); }
     if (slotId > 0) { query.bindValue(":slot_id", slotId); }
     
-    if (query.exec() && query.next()) {
+    if (StatementCache::exec(query) && query.next()) {
         return query.value(0).toInt();
     }
     return 0;
@@ -219,9 +290,26 @@ int GearDao::countGears(QSqlDatabase& db, int stationId, int slotId) {
 
 // 按状态统计数量
 int GearDao::countByStatus(QSqlDatabase& db, int status) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT COUNT(*) FROM raingear WHERE status = ?"));
+    QueryMetrics::Scope metricsScope("GearDao::countByStatus");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("SELECT COUNT(*) FROM raingear WHERE status = ?"));
+    QSqlQuery& query = *statement;
     query.addBindValue(status);
-    if (query.exec() && query.next()) { return query.value(0).toInt(); }
+    if (StatementCache::exec(query) && query.next()) { return query.value(0).toInt(); }
     return 0;
 }
+
+// 按一批ID查询雨具（分组 IN 查询）
+QHash<QString, GearInfoDTO> GearDao::selectDTOByIds(QSqlDatabase& db, const QVector<QString>& ids) {
+    QueryMetrics::Scope metricsScope("GearDao::selectDTOByIds");
+    return RowMapper<GearInfoDTO>::selectIn(db, "gear_id", ids, [](const GearInfoDTO& gear) { return gear.gearId; });
+}
+
+// 流式读取雨具
+StreamResult GearDao::streamDTO(QSqlDatabase& db, int stationId, const std::function<bool(const GearInfoDTO&)>& visitor,
+                                const CancelToken& token) {
+    QueryMetrics::Scope metricsScope("GearDao::streamDTO");
+    QVariantList binds;
+    if (stationId > 0) { binds.append(stationId); }
+    return RowMapper<GearInfoDTO>::stream(db, "gear_id", stationId > 0 ? QStringLiteral("station_id = ?") : QString(), binds,
+                                          [](const GearInfoDTO& gear) { return gear.gearId; }, visitor, token);
+}
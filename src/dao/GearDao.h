@@ -6,10 +6,17 @@
 #include<memory>
 #include<QString>
 #include<optional>
+#include<QSet>
+#include<QHash>
+#include<QPair>
+#include<functional>
 
 #include"../Model/RainGear.hpp"
 #include"../Model/GlobalEnum.hpp"
 #include"../Model/RainGear_subclasses.hpp"
+#include"PageCursor.h"
+#include"WriteResult.h"
+#include"../utils/DbExecutor.h"
 
 // 雨具基础信息DTO,用于管理员后台展示
 struct GearInfoDTO {
@@ -18,6 +25,7 @@ struct GearInfoDTO {
     int stationId;
     int slotId;
     int status;
+    int version = 0; // 行版本号，修改状态时回传
 };
 
 class GearDao{
@@ -28,12 +36,31 @@ public:
     
     bool isSlotOccupied(QSqlDatabase& db, Station station, int slot_id); // 检查槽位是否被占用
     bool insert(QSqlDatabase& db, const QString& gearId, GearType type, Station stationId, int slotId); // 插入雨具
+    // 批量插入雨具，多行 INSERT 每条最多 BATCH_INSERT_ROWS 行；stationId/slotId 为 0 时写 NULL（未入柜）
+    // 不开事务、不做校验，由调用方负责；任一条语句失败即返回 false
+    bool insertBatch(QSqlDatabase& db, const QVector<GearInfoDTO>& gears);
+    // 当前被占用的 (站点, 槽位)，ok 返回查询是否成功
+    QSet<QPair<int, int>> selectOccupiedSlots(QSqlDatabase& db, bool* ok = nullptr);
+    
+    static constexpr int BATCH_INSERT_ROWS = 150; // 每行 5 个参数，保证单条语句不超过 SQLite 默认的 999 个参数上限
     bool deleteById(QSqlDatabase& db, const QString& id); // 删除雨具
-    bool updateStatusAndLocation(QSqlDatabase& db, const QString& id, GearStatus status, Station station, int slot_id); // 更新雨具状态和位置
-    bool updateStatus(QSqlDatabase& db, const QString& id, int status); // 仅更新状态
+    // 更新雨具状态和位置 / 仅更新状态：expectedVersion 为读取时的版本号，不符时返回 Conflict
+    WriteResult updateStatusAndLocation(QSqlDatabase& db, const QString& id, GearStatus status, Station station, int slot_id,
+                                        int expectedVersion);
+    WriteResult updateStatus(QSqlDatabase& db, const QString& id, int status, int expectedVersion);
+    // 借伞时占用雨具：一条条件 UPDATE，只有雨具仍在该站点该槽位且可借时才改为借出并离开槽位
+    // 返回是否抢到（受影响行数为 1），两个终端同时借同一把伞只有一个能成功；ok 返回语句是否执行成功
+    bool claimForBorrow(QSqlDatabase& db, const QString& gearId, Station station, int slotId, bool* ok = nullptr);
     
     // 管理员后台Part
-    QVector<GearInfoDTO> selectAllDTO(QSqlDatabase& db, int stationId = 0, int slotId = 0, int limit = 0, int offset = 0); // 获取雨具DTO列表（支持分页）
+    // 按 gear_id 游标翻页获取雨具DTO列表，cursor 为当前页边界的 gear_id；最多返回 limit 条，按 gear_id 正序
+    // 实际多取一行，hasMore 返回 direction 方向上是否还有数据
+    QVector<GearInfoDTO> selectPageDTO(QSqlDatabase& db, int stationId, int slotId, const QString& cursor,
+                                       PageDirection direction, int limit, bool* hasMore = nullptr);
     int countGears(QSqlDatabase& db, int stationId = 0, int slotId = 0); // 统计雨具总数（用于分页）
     int countByStatus(QSqlDatabase& db, int status); // 按状态统计数量
+    QHash<QString, GearInfoDTO> selectDTOByIds(QSqlDatabase& db, const QVector<QString>& ids); // 按一批ID查询雨具，不存在的ID不出现在结果中
+    // 流式读取全部雨具（按 gear_id 升序，分块取回），stationId 为 0 时不限站点；visitor 返回 false 时停止
+    StreamResult streamDTO(QSqlDatabase& db, int stationId, const std::function<bool(const GearInfoDTO&)>& visitor,
+                           const CancelToken& token = CancelToken());
 };
\ No newline at end of file
@@ -0,0 +1,25 @@
+/*
+  游标（keyset）翻页。
+  列表按唯一键排序，翻页时带上当前页边界行的键，从该键之后/之前继续取，
+  不再用 OFFSET 让数据库扫描并丢弃前面所有的行，深页和首页一样快；翻页期间有新数据插入也不会重复或漏行。
+  流式读取（导出、全表统计）用同样的方式按块续读，内存占用只与块大小有关。
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+// 相对游标的取数方向
+enum class PageDirection {
+    After,     // 游标之后的一页（下一页）；游标为空时为第一页
+    AtOrAfter, // 从游标开始（含游标所在行）的一页，用于原地刷新当前页
+    Before     // 游标之前的一页（上一页），结果仍按正序返回
+};
+
+// 流式读取的结果
+struct StreamResult {
+    qint64 rows = 0;        // 交给 visitor 的行数
+    bool completed = false; // 读到了末尾
+    bool cancelled = false; // 被取消令牌或 visitor 中止
+    bool failed = false;    // 语句执行失败
+};
@@ -1,48 +1,60 @@
 #include "RecordDao.h"
+#include "RowMapper.h"
+#include "../utils/StatementCache.h"
+#include "../utils/SqlDialect.h"
+#include "../utils/QueryMetrics.h"
 
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
 #include <QVariant>
 #include <QTimeZone> 
+#include <QStringList>
+#include <algorithm>
 
 /*
   为了保证借还逻辑的一致性，在应用层统一了时间标准，强制使用系统时区进行解析，避免了数据库驱动层的自动转换干扰。
 */
 
 // add借出记录
-bool RecordDao::addBorrowRecord(QSqlDatabase& db, const QString& userId, const QString& gearId) {
-    QSqlQuery query(db);
-
+qint64 RecordDao::addBorrowRecord(QSqlDatabase& db, const QString& userId, const QString& gearId, Station stationId) {
+    QueryMetrics::Scope metricsScope("RecordDao::addBorrowRecord");
     QDateTime borrowTime = QDateTime::currentDateTime();
     QString borrowTimeStr = borrowTime.toString("yyyy-MM-dd hh:mm:ss"); //将得到的这个系统时间转换为字符串
     
-    query.prepare(QStringLiteral("INSERT INTO record (user_id, gear_id, borrow_time, cost) VALUES (?, ?, STR_TO_DATE(?, '%Y-%m-%d %H:%i:%s'), 0.0)"));
+    static const QString sql = QStringLiteral("INSERT INTO record (user_id, gear_id, station_id, borrow_time, cost) VALUES (?, ?, ?, %1, 0.0)")
+        .arg(SqlDialect::datetimeParam());
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(userId);
     query.addBindValue(gearId);
+    query.addBindValue(stationId == Station::Unknown ? QVariant() : QVariant(static_cast<int>(stationId)));
     query.addBindValue(borrowTimeStr);
 
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "插入借还记录失败:" << query.lastError().text();
-        return false;
+        return -1;
     }
-    return true;
+    return query.lastInsertId().toLongLong();
 }
 
 // 根据ID查找借伞未归还的记录
 std::optional<BorrowRecord> RecordDao::selectUnfinishedByUserId(QSqlDatabase& db, const QString& userId) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT record_id, user_id, gear_id, borrow_time, cost FROM record WHERE user_id = ? AND return_time IS NULL LIMIT 1"));
+    QueryMetrics::Scope metricsScope("RecordDao::selectUnfinishedByUserId");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "SELECT r.record_id, r.user_id, r.gear_id, r.borrow_time, r.cost FROM users u "
+        "JOIN record r ON r.record_id = u.open_record_id WHERE u.user_id = ? AND r.return_time IS NULL"));
+    QSqlQuery& query = *statement;
     query.addBindValue(userId);
 
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "查询未归还记录失败:" << query.lastError().text();
         return std::nullopt;
     }
     
     if (query.next()) {
         // 读取字符串
-        QString borrowTimeStr = query.value("borrow_time").toString();
+        QString borrowTimeStr = query.value(3).toString();
         QDateTime borrowTime;
         // 先尝试用 ISO 格式解析 (应对带 T 和 Z 的情况)
         QDateTime temp = QDateTime::fromString(borrowTimeStr, Qt::ISODate);
@@ -62,12 +74,12 @@ std::optional<BorrowRecord> RecordDao::selectUnfinishedByUserId(QSqlDatabase& db
         QDateTime returnTime; 
 
         return BorrowRecord(
-            query.value("record_id").toLongLong(), 
-            query.value("user_id").toString(), 
-            query.value("gear_id").toString(), 
+            query.value(0).toLongLong(), 
+            query.value(1).toString(), 
+            query.value(2).toString(), 
             borrowTime, 
             returnTime, 
-            query.value("cost").toDouble()
+            query.value(4).toDouble()
         );
     }
     return std::nullopt;
@@ -75,23 +87,26 @@ std::optional<BorrowRecord> RecordDao::selectUnfinishedByUserId(QSqlDatabase& db
 
 // 更新还伞结账信息,这里传入record_id作为参数
 bool RecordDao::updateReturnInfo(QSqlDatabase& db, qint64 recordId, const QDateTime& returnTime, double cost) {
-    QSqlQuery query(db);
+    QueryMetrics::Scope metricsScope("RecordDao::updateReturnInfo");
     // 使用字符串格式存储，完全避免时区问题
     QString returnTimeStr = returnTime.toString("yyyy-MM-dd hh:mm:ss");
     // 更新return_time为传入的时间，写入费用（确保与计费时使用的时间一致）
-    query.prepare(QStringLiteral("UPDATE record SET return_time = STR_TO_DATE(?, '%Y-%m-%d %H:%i:%s'), cost = ? WHERE record_id = ?"));
+    static const QString sql = QStringLiteral("UPDATE record SET return_time = %1, cost = ? WHERE record_id = ? AND return_time IS NULL")
+        .arg(SqlDialect::datetimeParam());
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(returnTimeStr);
     query.addBindValue(cost);
     query.addBindValue(recordId);
 
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "更新还伞记录失败:" << query.lastError().text();
         return false;
     }
     
     // 验证更新是否成功
     if (query.numRowsAffected() == 0) {
-        qWarning() << "更新还伞记录：未找到对应的记录ID" << recordId;
+        qWarning() << "更新还伞记录：记录不存在或已结单" << recordId;
         return false;
     }
     
@@ -101,25 +116,96 @@ bool RecordDao::updateReturnInfo(QSqlDatabase& db, qint64 recordId, const QDateT
 
 
 // 管理员后台Part
-// 获取最近订单
-QVector<OrderInfoDTO> RecordDao::selectRecent(QSqlDatabase& db, int limit) {
+// 订单筛选条件转成 SQL 条件和按顺序对应的 ? 参数
+static void appendFilterConditions(const OrderFilter& filter, QStringList& conditions, QVariantList& binds) {
+    const QString timeParam = SqlDialect::datetimeParam();
+    if (filter.borrowFrom.isValid()) {
+        conditions.append("borrow_time >= " + timeParam);
+        binds.append(filter.borrowFrom.toString("yyyy-MM-dd hh:mm:ss"));
+    }
+    if (filter.borrowTo.isValid()) {
+        conditions.append("borrow_time < " + timeParam);
+        binds.append(filter.borrowTo.toString("yyyy-MM-dd hh:mm:ss"));
+    }
+    if (!filter.userId.isEmpty()) {
+        conditions.append("user_id = ?");
+        binds.append(filter.userId);
+    }
+    if (!filter.gearId.isEmpty()) {
+        conditions.append("gear_id = ?");
+        binds.append(filter.gearId);
+    }
+    if (filter.stationId > 0) {
+        conditions.append("station_id = ?");
+        binds.append(filter.stationId);
+    }
+    if (filter.status == OrderStatus::Open) {
+        conditions.append("return_time IS NULL");
+    } else if (filter.status == OrderStatus::Closed) {
+        conditions.append("return_time IS NOT NULL");
+    }
+}
+
+// 按条件分页查询订单
+// 每个筛选条件都有以 borrow_time 为第二列的索引，过滤后直接按索引顺序取到游标位置，不需要对整表排序
+QVector<OrderInfoDTO> RecordDao::selectPageDTO(QSqlDatabase& db, const OrderFilter& filter, const OrderCursor& cursor,
+                                              PageDirection direction, int limit, bool* hasMore) {
+    QueryMetrics::Scope metricsScope("RecordDao::selectPageDTO");
     QVector<OrderInfoDTO> result;
-    QSqlQuery query(db);
-    query.prepare(QString("SELECT record_id, user_id, gear_id, borrow_time, return_time, cost FROM record ORDER BY borrow_time DESC LIMIT %1").arg(limit));
+    const bool backward = direction == PageDirection::Before;
+    const QString timeParam = SqlDialect::datetimeParam();
     
-    if (!query.exec()) { return result; }
+    QStringList conditions;
+    QVariantList binds;
+    appendFilterConditions(filter, conditions, binds);
+    // 显示顺序是倒序，“之后”指更早的订单；上一页按正序取紧挨着游标的那些行，取回后再翻转
+    if (!cursor.isNull()) {
+        const char* timeOp = backward ? ">" : "<";
+        const char* idOp = backward ? ">" : direction == PageDirection::AtOrAfter ? "<=" : "<";
+        conditions.append(QStringLiteral("(borrow_time %1 %2 OR (borrow_time = %2 AND record_id %3 ?))")
+            .arg(QLatin1String(timeOp), timeParam, QLatin1String(idOp)));
+        binds.append(cursor.borrowTime);
+        binds.append(cursor.borrowTime);
+        binds.append(cursor.recordId);
+    }
     
-    while (query.next()) {
-        QString returnTime = query.value("return_time").isNull() ? QString() 
-            : query.value("return_time").toDateTime().toString("yyyy-MM-dd hh:mm:ss");
-        result.append(OrderInfoDTO{
-            query.value("record_id").toLongLong(), 
-            query.value("user_id").toString(), 
-            query.value("gear_id").toString(), 
-            query.value("borrow_time").toDateTime().toString("yyyy-MM-dd hh:mm:ss"), 
-            returnTime, 
-            query.value("cost").toDouble()
-        });
+    QString sql = RowMapper<OrderInfoDTO>::select(conditions.isEmpty() ? QString() : "WHERE " + conditions.join(" AND "));
+    sql += backward ? " ORDER BY borrow_time ASC, record_id ASC LIMIT ?" : " ORDER BY borrow_time DESC, record_id DESC LIMIT ?";
+    binds.append(limit + 1);
+    
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
+    for (const QVariant& value : binds) {
+        query.addBindValue(value);
     }
+    if (!StatementCache::exec(query)) {
+        qCritical() << "查询订单失败:" << query.lastError().text();
+        if (hasMore) { *hasMore = false; }
+        return result;
+    }
+    result.reserve(limit + 1);
+    RowMapper<OrderInfoDTO>::readAll(query, result);
+    
+    const bool more = result.size() > limit;
+    if (more) { result.removeLast(); }
+    if (backward) { std::reverse(result.begin(), result.end()); }
+    if (hasMore) { *hasMore = more; }
     return result;
-}
\ No newline at end of file
+}
+
+// 按一批流水号查询订单（分组 IN 查询）
+QHash<qint64, OrderInfoDTO> RecordDao::selectDTOByIds(QSqlDatabase& db, const QVector<qint64>& recordIds) {
+    QueryMetrics::Scope metricsScope("RecordDao::selectDTOByIds");
+    return RowMapper<OrderInfoDTO>::selectIn(db, "record_id", recordIds, [](const OrderInfoDTO& order) { return order.recordId; });
+}
+
+// 按条件流式读取订单（按流水号升序）
+StreamResult RecordDao::streamDTO(QSqlDatabase& db, const OrderFilter& filter,
+                                  const std::function<bool(const OrderInfoDTO&)>& visitor, const CancelToken& token) {
+    QueryMetrics::Scope metricsScope("RecordDao::streamDTO");
+    QStringList conditions;
+    QVariantList binds;
+    appendFilterConditions(filter, conditions, binds);
+    return RowMapper<OrderInfoDTO>::stream(db, "record_id", conditions.join(" AND "), binds,
+                                           [](const OrderInfoDTO& order) { return order.recordId; }, visitor, token);
+}
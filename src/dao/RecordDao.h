@@ -2,9 +2,15 @@
 #include<QSqlDatabase>
 #include<QString>
 #include<QVector>
+#include<QHash>
+#include<QDateTime>
 #include<optional>
+#include<functional>
 
 #include"../Model/BorrowRecord.h"
+#include"../Model/GlobalEnum.hpp"
+#include"PageCursor.h"
+#include"../utils/DbExecutor.h"
 
 // 订单信息DTO,管理员后台用
 struct OrderInfoDTO {
@@ -14,17 +20,51 @@ struct OrderInfoDTO {
     QString borrowTime;
     QString returnTime;
     double cost;
+    int stationId;       // 借出站点，旧数据为 0
+};
+
+// 订单状态筛选
+enum class OrderStatus {
+    All,
+    Open,   // 未归还
+    Closed  // 已归还
+};
+
+// 订单查询条件，未设置的字段不参与过滤
+struct OrderFilter {
+    QDateTime borrowFrom;  // 借出时间下限（含）
+    QDateTime borrowTo;    // 借出时间上限（不含）
+    QString userId;
+    QString gearId;
+    int stationId = 0;     // 借出站点
+    OrderStatus status = OrderStatus::All;
+};
+
+// 订单列表的游标：按 (borrow_time, record_id) 倒序，record_id 保证借出时间相同时顺序仍然确定
+struct OrderCursor {
+    QString borrowTime;    // 'yyyy-MM-dd hh:mm:ss'
+    qint64 recordId = 0;
+    bool isNull() const { return recordId <= 0; }
 };
 
 class RecordDao {
 public:
-    // add借出记录
-    bool addBorrowRecord(QSqlDatabase& db, const QString& userId, const QString& gearId);
+    // add借出记录，返回新记录的 record_id，失败时返回 -1
+    qint64 addBorrowRecord(QSqlDatabase& db, const QString& userId, const QString& gearId, Station stationId);
     // 查找未归还记录,这里需要返回 BorrowRecord 对象给 Service 层用来算钱
+    // 经 users.open_record_id 指针定位，两次主键查找，与用户的历史订单数无关
     std::optional<BorrowRecord> selectUnfinishedByUserId(QSqlDatabase& db, const QString& userId);
-    // 结单,更新归还时间与费用
+    // 结单,更新归还时间与费用；已结单的记录不会被再次更新
     bool updateReturnInfo(QSqlDatabase& db, qint64 recordId, const QDateTime& returnTime, double cost);
     
     // 管理员后台Part
-    QVector<OrderInfoDTO> selectRecent(QSqlDatabase& db, int limit = 50); // 获取最近订单
+    // 按条件查询订单，最新的在前；cursor 为当前页边界的订单，为空时取第一页。最多返回 limit 条，按显示顺序
+    // 实际多取一行，hasMore 返回 direction 方向上是否还有数据
+    QVector<OrderInfoDTO> selectPageDTO(QSqlDatabase& db, const OrderFilter& filter, const OrderCursor& cursor,
+                                        PageDirection direction, int limit, bool* hasMore = nullptr);
+    // 按一批流水号查询订单，不存在的流水号不出现在结果中
+    QHash<qint64, OrderInfoDTO> selectDTOByIds(QSqlDatabase& db, const QVector<qint64>& recordIds);
+    // 按条件流式读取订单（按流水号升序，分块取回，内存占用与总数无关），visitor 返回 false 时停止，用于导出和统计
+    StreamResult streamDTO(QSqlDatabase& db, const OrderFilter& filter,
+                           const std::function<bool(const OrderInfoDTO&)>& visitor, const CancelToken& token = CancelToken());
 };
\ No newline at end of file
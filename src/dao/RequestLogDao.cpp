@@ -0,0 +1,67 @@
+#include "RequestLogDao.h"
+#include "../utils/StatementCache.h"
+#include "../utils/SqlDialect.h"
+#include "../utils/QueryMetrics.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+// 查询请求结果
+std::optional<RequestLogEntry> RequestLogDao::selectResult(QSqlDatabase& db, const QString& requestId, const QString& userId,
+                                                           const QDateTime& notBefore) {
+    QueryMetrics::Scope metricsScope("RequestLogDao::selectResult");
+    static const QString sql = QStringLiteral(
+        "SELECT kind, message, cost FROM request_log WHERE request_id = ? AND user_id = ? AND created_at >= %1")
+        .arg(SqlDialect::datetimeParam());
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
+    query.addBindValue(requestId);
+    query.addBindValue(userId);
+    query.addBindValue(notBefore.toString("yyyy-MM-dd hh:mm:ss"));
+    if (!StatementCache::exec(query)) {
+        qCritical() << "查询请求记录失败:" << query.lastError().text();
+        return std::nullopt;
+    }
+    if (!query.next()) return std::nullopt;
+    RequestLogEntry entry;
+    entry.kind = static_cast<RequestKind>(query.value(0).toInt());
+    entry.message = query.value(1).toString();
+    entry.cost = query.value(2).toDouble();
+    return entry;
+}
+
+// 记录成功的请求
+bool RequestLogDao::insertResult(QSqlDatabase& db, const QString& requestId, const QString& userId, const RequestLogEntry& entry) {
+    QueryMetrics::Scope metricsScope("RequestLogDao::insertResult");
+    static const QString sql = QStringLiteral(
+        "INSERT INTO request_log (request_id, user_id, kind, message, cost, created_at) VALUES (?, ?, ?, ?, ?, %1)")
+        .arg(SqlDialect::datetimeParam());
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
+    query.addBindValue(requestId);
+    query.addBindValue(userId);
+    query.addBindValue(static_cast<int>(entry.kind));
+    query.addBindValue(entry.message);
+    query.addBindValue(entry.cost);
+    query.addBindValue(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
+    if (!StatementCache::exec(query)) {
+        qCritical() << "写入请求记录失败:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 清理过期记录，走 idx_created_at
+int RequestLogDao::purgeBefore(QSqlDatabase& db, const QDateTime& before) {
+    QueryMetrics::Scope metricsScope("RequestLogDao::purgeBefore");
+    static const QString sql = QStringLiteral("DELETE FROM request_log WHERE created_at < %1").arg(SqlDialect::datetimeParam());
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
+    query.addBindValue(before.toString("yyyy-MM-dd hh:mm:ss"));
+    if (!StatementCache::exec(query)) {
+        qWarning() << "清理请求记录失败:" << query.lastError().text();
+        return -1;
+    }
+    return query.numRowsAffected();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include<QSqlDatabase>
+#include<QString>
+#include<QDateTime>
+#include<optional>
+
+// 借还请求类型
+enum class RequestKind {
+    Borrow = 1,
+    Return = 2
+};
+
+// 已成功执行的借还请求的结果，终端重试同一请求时原样返回
+struct RequestLogEntry {
+    RequestKind kind;
+    QString message;
+    double cost = 0.0;
+};
+
+// 借还请求去重表：request_id 由终端生成，成功的请求在业务事务里一并写入，
+// 超过保留期的记录按 created_at 定期清理
+class RequestLogDao {
+public:
+    // 查询 notBefore 之后记录的请求结果，request_id 和 user_id 都要匹配
+    std::optional<RequestLogEntry> selectResult(QSqlDatabase& db, const QString& requestId, const QString& userId,
+                                                const QDateTime& notBefore);
+    // 记录成功的请求，须在业务事务内调用；同一 request_id 已存在时失败（主键冲突）
+    bool insertResult(QSqlDatabase& db, const QString& requestId, const QString& userId, const RequestLogEntry& entry);
+    // 删除 before 之前的记录，返回删除的行数，失败时返回 -1
+    int purgeBefore(QSqlDatabase& db, const QDateTime& before);
+};
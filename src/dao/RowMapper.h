@@ -0,0 +1,293 @@
+/*
+  DAO 行映射。
+  每个 DTO / 模型类型特化一次 RowMapping<T>：用枚举声明列的下标，用同顺序的 columns 声明列名，
+  RowMapper<T> 据此生成 SELECT 列表，解码时按编译期确定的下标取值，不再逐行逐列按列名查找，
+  SQL 里的列顺序和解码顺序出自同一份声明，不会错位。
+  联表查询时可以给列加表别名，并从结果集的第 base 列开始解码；selectIn() 按一批键分组执行 IN 查询，
+  stream() 按键分块流式读取大表。
+ */
+
+#pragma once
+
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QSqlError>
+#include <QDebug>
+#include <array>
+#include <memory>
+
+#include "GearDao.h"
+#include "RecordDao.h"
+#include "PageCursor.h"
+#include "UserDao.h"
+#include "../Model/User.h"
+#include "../Model/RainGearFactory.h"
+#include "../utils/StatementCache.h"
+#include "../utils/DbExecutor.h"
+
+// 特化须提供：Column 枚举（以 ColumnCount 结尾）、table、columns、read(query, base)
+template<typename T>
+struct RowMapping;
+
+template<typename T>
+class RowMapper {
+public:
+    using Mapping = RowMapping<T>;
+    static constexpr int columnCount = Mapping::ColumnCount;
+    static_assert(std::tuple_size<decltype(Mapping::columns)>::value == Mapping::ColumnCount,
+                  "RowMapping 的 columns 与 Column 枚举数量不一致");
+
+    // 逗号分隔的列表，如 "gear_id, type_id, ..."；alias 非空时为 "g.gear_id, g.type_id, ..."
+    static QString selectList(const QString& alias = QString()) {
+        QStringList names;
+        names.reserve(columnCount);
+        const QString prefix = alias.isEmpty() ? QString() : alias + QLatin1Char('.');
+        for (const char* column : Mapping::columns) {
+            names.append(prefix + QLatin1String(column));
+        }
+        return names.join(QStringLiteral(", "));
+    }
+
+    // "SELECT <列表> FROM <表> " 加上调用方的条件部分
+    static QString select(const QString& tail) {
+        return QStringLiteral("SELECT ") + selectList() + QStringLiteral(" FROM ")
+             + QLatin1String(Mapping::table) + QLatin1Char(' ') + tail;
+    }
+
+    // 解码当前行，base 为本类型第一列在结果集中的下标
+    static auto read(const QSqlQuery& query, int base = 0) { return Mapping::read(query, base); }
+
+    // 读出剩余所有行追加到 out（QVector / std::vector 均可）
+    template<typename Container>
+    static void readAll(QSqlQuery& query, Container& out) {
+        while (query.next()) {
+            out.push_back(Mapping::read(query, 0));
+        }
+    }
+
+    // 按键批量查询，结果以 keyOf(行) 为键放进哈希表，供调用方在内存中关联。
+    // keys 去重后每 IN_CHUNK 个一组执行 "WHERE keyColumn IN (?, ...)"，往返次数固定为 ceil(n / IN_CHUNK)；
+    // 最后一组用最后一个键补齐，所有组的语句文本相同，只需 prepare 一次。ok 返回是否全部执行成功
+    static constexpr int IN_CHUNK = 100;
+
+    template<typename Key, typename KeyOf>
+    static QHash<Key, T> selectIn(QSqlDatabase& db, const char* keyColumn, const QVector<Key>& keys, KeyOf keyOf,
+                                  bool* ok = nullptr) {
+        QHash<Key, T> result;
+        if (ok) *ok = true;
+        QVector<Key> unique;
+        unique.reserve(keys.size());
+        QSet<Key> seen;
+        for (const Key& key : keys) {
+            if (!seen.contains(key)) {
+                seen.insert(key);
+                unique.append(key);
+            }
+        }
+        if (unique.isEmpty()) return result;
+        result.reserve(unique.size());
+
+        QStringList holders;
+        for (int i = 0; i < IN_CHUNK; ++i) holders.append(QStringLiteral("?"));
+        const QString sql = select(QStringLiteral("WHERE %1 IN (%2)").arg(QLatin1String(keyColumn), holders.join(QStringLiteral(", "))));
+
+        for (int begin = 0; begin < unique.size(); begin += IN_CHUNK) {
+            CachedQuery statement = StatementCache::prepare(db, sql);
+            QSqlQuery& query = *statement;
+            for (int i = 0; i < IN_CHUNK; ++i) {
+                query.addBindValue(unique[qMin(begin + i, static_cast<int>(unique.size()) - 1)]);
+            }
+            if (!StatementCache::exec(query)) {
+                qWarning() << "[RowMapper::selectIn]" << Mapping::table << "Error:" << query.lastError().text();
+                if (ok) *ok = false;
+                continue;
+            }
+            while (query.next()) {
+                T row = Mapping::read(query, 0);
+                result.insert(keyOf(row), row);
+            }
+        }
+        return result;
+    }
+
+    // 流式读取：按 keyColumn 升序每次取 chunkSize 行，下一块从上一块最后一行的键之后继续（keyset），
+    // 逐行交给 visitor(const T&)，visitor 返回 false 或 token 被取消时停止。
+    // 语句设为 forward-only，驱动不为回滚保留已读过的行，内存占用只与 chunkSize 有关，与总行数无关。
+    // condition 为不含 WHERE 的过滤条件（可为空），binds 为其中的 ? 参数；keyColumn 须唯一
+    static constexpr int STREAM_CHUNK = 1000;
+
+    template<typename KeyOf, typename Visitor>
+    static StreamResult stream(QSqlDatabase& db, const char* keyColumn, const QString& condition, const QVariantList& binds,
+                               KeyOf keyOf, Visitor&& visitor, const CancelToken& token = CancelToken(),
+                               int chunkSize = STREAM_CHUNK) {
+        StreamResult result;
+        const QString key = QLatin1String(keyColumn);
+        const QString order = QStringLiteral("ORDER BY %1 LIMIT ?").arg(key);
+        const QString firstSql = select((condition.isEmpty() ? QString() : QStringLiteral("WHERE (%1) ").arg(condition)) + order);
+        const QString nextSql = select((condition.isEmpty() ? QStringLiteral("WHERE ") : QStringLiteral("WHERE (%1) AND ").arg(condition))
+                                       + QStringLiteral("%1 > ? ").arg(key) + order);
+
+        // 不走语句缓存：forward-only 须在 prepare 之前设置；每次流式读取各 prepare 一次，之后每块只重新绑定参数
+        QSqlQuery firstChunk(db);
+        QSqlQuery nextChunk(db);
+        firstChunk.setForwardOnly(true);
+        nextChunk.setForwardOnly(true);
+        if (!firstChunk.prepare(firstSql) || !nextChunk.prepare(nextSql)) {
+            qWarning() << "[RowMapper::stream]" << Mapping::table << "Error:"
+                       << (firstChunk.lastError().isValid() ? firstChunk.lastError() : nextChunk.lastError()).text();
+            result.failed = true;
+            return result;
+        }
+
+        QVariant lastKey;
+        for (;;) {
+            if (token.isCancelled()) {
+                result.cancelled = true;
+                return result;
+            }
+            QSqlQuery& query = lastKey.isValid() ? nextChunk : firstChunk;
+            for (const QVariant& value : binds) query.addBindValue(value);
+            if (lastKey.isValid()) query.addBindValue(lastKey);
+            query.addBindValue(chunkSize);
+            if (!StatementCache::exec(query)) {
+                qWarning() << "[RowMapper::stream]" << Mapping::table << "Error:" << query.lastError().text();
+                result.failed = true;
+                return result;
+            }
+            int fetched = 0;
+            while (query.next()) {
+                const T row = Mapping::read(query, 0);
+                ++fetched;
+                ++result.rows;
+                lastKey = QVariant::fromValue(keyOf(row));
+                if (!visitor(row)) {
+                    query.finish();
+                    result.cancelled = true;
+                    return result;
+                }
+            }
+            query.finish(); // 释放这一块的结果集
+            if (fetched < chunkSize) {
+                result.completed = true;
+                return result;
+            }
+        }
+    }
+};
+
+// 雨具表，解码为具体子类对象；type_id 未知时为 nullptr
+template<>
+struct RowMapping<RainGear> {
+    enum Column { GearId, TypeId, StationId, SlotId, Status, Version, ColumnCount };
+    static constexpr const char* table = "raingear";
+    static constexpr std::array<const char*, ColumnCount> columns {
+        "gear_id", "type_id", "station_id", "slot_id", "status", "version"
+    };
+
+    static std::unique_ptr<RainGear> read(const QSqlQuery& query, int base) {
+        auto gear = RainGearFactory::create_raingear(static_cast<GearType>(query.value(base + TypeId).toInt()),
+                                                     query.value(base + GearId).toString());
+        if (gear) {
+            gear->set_status(static_cast<GearStatus>(query.value(base + Status).toInt()));
+            gear->set_station_id(static_cast<Station>(query.value(base + StationId).toInt()));
+            gear->set_slot_id(query.value(base + SlotId).toInt());
+            gear->set_version(query.value(base + Version).toInt());
+        }
+        return gear;
+    }
+};
+
+// 雨具表，管理员后台列表用
+template<>
+struct RowMapping<GearInfoDTO> {
+    enum Column { GearId, TypeId, StationId, SlotId, Status, Version, ColumnCount };
+    static constexpr const char* table = "raingear";
+    static constexpr std::array<const char*, ColumnCount> columns {
+        "gear_id", "type_id", "station_id", "slot_id", "status", "version"
+    };
+
+    static GearInfoDTO read(const QSqlQuery& query, int base) {
+        return GearInfoDTO{
+            query.value(base + GearId).toString(),
+            query.value(base + TypeId).toInt(),
+            query.value(base + StationId).toInt(),
+            query.value(base + SlotId).toInt(),
+            query.value(base + Status).toInt(),
+            query.value(base + Version).toInt()
+        };
+    }
+};
+
+// 用户表
+template<>
+struct RowMapping<User> {
+    enum Column { UserId, RealName, Password, Role, Credit, IsActive, ColumnCount };
+    static constexpr const char* table = "users";
+    static constexpr std::array<const char*, ColumnCount> columns {
+        "user_id", "real_name", "password", "role", "credit", "is_active"
+    };
+
+    static User read(const QSqlQuery& query, int base) {
+        return User(query.value(base + UserId).toString(),
+                    query.value(base + RealName).toString(),
+                    query.value(base + Password).toString(),
+                    query.value(base + Role).toInt(),
+                    query.value(base + Credit).toDouble(),
+                    query.value(base + IsActive).toBool());
+    }
+};
+
+// 用户表，管理员后台列表用，不含密码列
+template<>
+struct RowMapping<UserInfoDTO> {
+    enum Column { UserId, RealName, Role, Credit, IsActive, ColumnCount };
+    static constexpr const char* table = "users";
+    static constexpr std::array<const char*, ColumnCount> columns {
+        "user_id", "real_name", "role", "credit", "is_active"
+    };
+
+    static UserInfoDTO read(const QSqlQuery& query, int base) {
+        return UserInfoDTO{
+            query.value(base + UserId).toString(),
+            query.value(base + RealName).toString(),
+            query.value(base + Role).toInt(),
+            query.value(base + Credit).toDouble(),
+            query.value(base + IsActive).toBool()
+        };
+    }
+};
+
+// 借还记录表，管理员后台订单列表用
+template<>
+struct RowMapping<OrderInfoDTO> {
+    enum Column { RecordId, UserId, GearId, BorrowTime, ReturnTime, Cost, StationId, ColumnCount };
+    static constexpr const char* table = "record";
+    static constexpr std::array<const char*, ColumnCount> columns {
+        "record_id", "user_id", "gear_id", "borrow_time", "return_time", "cost", "station_id"
+    };
+
+    // 时间列统一格式化为 'yyyy-MM-dd hh:mm:ss'。MySQL 驱动返回 QDateTime，SQLite 返回同格式的文本
+    static QString formatDateTime(const QVariant& value) {
+        QDateTime dt = value.toDateTime();
+        if (!dt.isValid()) { return value.toString(); }
+        return dt.toString("yyyy-MM-dd hh:mm:ss");
+    }
+
+    static OrderInfoDTO read(const QSqlQuery& query, int base) {
+        QVariant returnTime = query.value(base + ReturnTime);
+        return OrderInfoDTO{
+            query.value(base + RecordId).toLongLong(),
+            query.value(base + UserId).toString(),
+            query.value(base + GearId).toString(),
+            formatDateTime(query.value(base + BorrowTime)),
+            returnTime.isNull() ? QString() : formatDateTime(returnTime),
+            query.value(base + Cost).toDouble(),
+            query.value(base + StationId).toInt()
+        };
+    }
+};
@@ -1,120 +1,176 @@
 #include"StationDao.h"
-#include"GearDao.h"
+#include"RowMapper.h"
+#include"../utils/StatementCache.h"
+#include"../utils/QueryMetrics.h"
 
 #include<QSqlQuery>
 #include<QSqlError>
 #include<QDebug>
 #include<QStringList>
+#include<QHash>
+#include<QMutex>
+#include<QElapsedTimer>
 
 
-// select_all，查出所有站点包含的所有的雨具的完整信息
+// 站点和雨具一次 LEFT JOIN 查出，没有雨具的站点也会返回一行（雨具列为 NULL）
+// 列顺序固定，按下标取值：0-4 为站点列，从 kGearBase 开始为雨具列（RowMapping<RainGear> 的列顺序）
+static constexpr int kGearBase = 5;
+
+static QString stationWithGearsSelect(const QString& tail) {
+    return QStringLiteral("SELECT s.station_id, s.pos_x, s.pos_y, s.status, s.unavailable_slots, ")
+         + RowMapper<RainGear>::selectList(QStringLiteral("g"))
+         + QStringLiteral(" FROM station s LEFT JOIN raingear g ON g.station_id = s.station_id ") + tail;
+}
+
+// 用当前行的站点列创建Stationlocal对象
+static std::unique_ptr<Stationlocal> buildStation(const QSqlQuery& query) {
+    Station sid = static_cast<Station>(query.value(0).toInt());
+    auto stationObj = std::make_unique<Stationlocal>(sid, query.value(1).toDouble(), query.value(2).toDouble());
+    stationObj->set_online(query.value(3).toInt() == 1);
+
+    // 解析故障槽位字符串，数据库中是以逗号分隔的字符串如"1,5"
+    QString badSlotsStr = query.value(4).toString();
+    if (!badSlotsStr.isEmpty()) {
+        QStringList slotList = badSlotsStr.split(',', Qt::SkipEmptyParts);
+        for (const QString& s : slotList) {
+            stationObj->mark_unavailable(s.toInt());
+        }
+    }
+    return stationObj;
+}
+
+// 当前行带有雨具时放进站点对应槽位
+static void attachGear(Stationlocal& station, const QSqlQuery& query) {
+    if (query.isNull(kGearBase)) return; // 该站点没有雨具
+    auto gear = RowMapper<RainGear>::read(query, kGearBase);
+    if (!gear) return;
+    station.add_gear(gear->get_slot_id(), std::move(gear));
+}
+
+// select_all，查出所有站点包含的所有的雨具的完整信息（一次往返）
 std::vector<std::unique_ptr<Stationlocal>> StationDao::selectAll(QSqlDatabase& db) {
+    QueryMetrics::Scope metricsScope("StationDao::selectAll");
     std::vector<std::unique_ptr<Stationlocal>> stationList;
     stationList.reserve(20);
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT * FROM station ORDER BY station_id"));
+    static const QString sql = stationWithGearsSelect(QStringLiteral("ORDER BY s.station_id"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
 
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "查询站点失败:" << query.lastError().text();
         return stationList;
     }
 
-    // 用于查询某个站点的所有雨具的信息，将雨具信息传给Stationlocal类
-    GearDao gearDao;
+    // 结果按站点排序，站点ID变化时开始组装下一个站点
+    int currentId = -1;
     while (query.next()) {
-        // 从station表读基础数据信息
-        int idInt=query.value("station_id").toInt();
-        Station sid=static_cast<Station>(idInt);
-        double x=query.value("pos_x").toDouble();
-        double y=query.value("pos_y").toDouble();
-        bool isOnline=(query.value("status").toInt()==1);
-        QString badSlotsStr =query.value("unavailable_slots").toString();
-
-        // 创建Stationlocal对象
-        auto stationObj=std::make_unique<Stationlocal>(sid, x, y);
-        stationObj->set_online(isOnline);
-
-        // 解析故障槽位字符串，数据库中是以逗号分隔的字符串如"1,5"
-        if (!badSlotsStr.isEmpty()) {
-            QStringList slotList = badSlotsStr.split(',', Qt::SkipEmptyParts);
-            for (const QString& s : slotList) {
-                int slotIndex = s.toInt();
-                // 标记该槽位不可用
-                stationObj->mark_unavailable(slotIndex);
-            }
-        }
-
-        // 调用GearDao查出该站点下的所有伞
-        auto gears = gearDao.selectByStation(db, sid);
-        for (size_t i = 0; i < gears.size(); ++i) {
-            auto& gear = gears[i];
-            if (gear) {
-                int slotIdx = gear->get_slot_id();
-                stationObj->add_gear(slotIdx, std::move(gear));
-            }
+        int idInt = query.value(0).toInt();
+        if (stationList.empty() || idInt != currentId) {
+            currentId = idInt;
+            stationList.push_back(buildStation(query));
         }
-
-        stationList.push_back(std::move(stationObj));
+        attachGear(*stationList.back(), query);
     }
 
     return stationList;
 }
 
-// select_by_id，查出单个站点包含的所有的雨具的完整信息
+// select_by_id，查出单个站点包含的所有的雨具的完整信息（一次往返）
 std::unique_ptr<Stationlocal> StationDao::selectById(QSqlDatabase& db, Station stationId) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT * FROM station WHERE station_id = ?"));
+    QueryMetrics::Scope metricsScope("StationDao::selectById");
+    static const QString sql = stationWithGearsSelect(QStringLiteral("WHERE s.station_id = ?"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.addBindValue(static_cast<int>(stationId));
 
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "查询站点失败:" << query.lastError().text();
         return nullptr;
     }
 
-    if (query.next()) {
-        // 从station表读基础数据信息
-        double x = query.value("pos_x").toDouble();
-        double y = query.value("pos_y").toDouble();
-        bool isOnline = (query.value("status").toInt() == 1);
-        QString badSlotsStr = query.value("unavailable_slots").toString();
-        // 创建Stationlocal对象
-        auto stationObj = std::make_unique<Stationlocal>(stationId, x, y);
-        stationObj->set_online(isOnline);
-
-        if (!badSlotsStr.isEmpty()) {
-            QStringList slotList = badSlotsStr.split(',', Qt::SkipEmptyParts);
-            for (const QString& s : slotList) {
-                stationObj->mark_unavailable(s.toInt());
-            }
-        }
+    std::unique_ptr<Stationlocal> stationObj;
+    while (query.next()) {
+        if (!stationObj) stationObj = buildStation(query);
+        attachGear(*stationObj, query);
+    }
+    return stationObj;
+}
+
+// 解析故障槽位字符串（如 "1,5"）为位掩码
+static quint32 parseFaultMask(const QString& badSlotsStr) {
+    quint32 mask = 0;
+    for (const QString& s : badSlotsStr.split(',', Qt::SkipEmptyParts)) {
+        int slot = s.trimmed().toInt();
+        if (slot > 0 && slot < 32) mask |= 1u << slot;
+    }
+    return mask;
+}
 
-        // 填充雨具
-        GearDao gearDao;
-        auto gears = gearDao.selectByStation(db, stationId);
-        for (size_t i = 0; i < gears.size(); ++i) {
-            auto& gear = gears[i];
-            if (gear) {
-                int slotIdx = gear->get_slot_id();
-                stationObj->add_gear(slotIdx, std::move(gear));
-            }
+// 站点闸口查询
+std::optional<StationGate> StationDao::selectGate(QSqlDatabase& db, Station station) {
+    QueryMetrics::Scope metricsScope("StationDao::selectGate");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("SELECT status, unavailable_slots FROM station WHERE station_id = ?"));
+    QSqlQuery& query = *statement;
+    query.addBindValue(static_cast<int>(station));
+    if (!StatementCache::exec(query)) {
+        qCritical() << "查询站点状态失败:" << query.lastError().text();
+        return std::nullopt;
+    }
+    if (!query.next()) return std::nullopt;
+    StationGate gate;
+    gate.isOnline = query.value(0).toInt() == 1;
+    gate.faultMask = parseFaultMask(query.value(1).toString());
+    return gate;
+}
+
+// 闸口缓存，进程内所有 StationDao 共用
+namespace {
+struct CachedGate {
+    StationGate gate;
+    QElapsedTimer loadedAt;
+};
+QMutex gateCacheMutex;
+QHash<int, CachedGate> gateCache;
+}
+
+std::optional<StationGate> StationDao::selectGateCached(QSqlDatabase& db, Station station, int maxAgeMs) {
+    const int stationId = static_cast<int>(station);
+    {
+        QMutexLocker locker(&gateCacheMutex);
+        auto it = gateCache.constFind(stationId);
+        if (it != gateCache.constEnd() && !it->loadedAt.hasExpired(maxAgeMs)) {
+            return it->gate;
         }
-        return stationObj;
     }
+    // 查询放在锁外，并发的未命中各查一次即可
+    auto gate = selectGate(db, station);
+    if (gate) {
+        CachedGate entry;
+        entry.gate = *gate;
+        entry.loadedAt.start();
+        QMutexLocker locker(&gateCacheMutex);
+        gateCache.insert(stationId, entry);
+    }
+    return gate;
+}
 
-    return nullptr;
+void StationDao::invalidateGate(int stationId) {
+    QMutexLocker locker(&gateCacheMutex);
+    gateCache.remove(stationId);
 }
 
 // 获取各站点的地图信息（库存数量和在线状态，用于地图显示）
 QMap<int, StationMapInfo> StationDao::selectStationMapInfo(QSqlDatabase& db) {
+    QueryMetrics::Scope metricsScope("StationDao::selectStationMapInfo");
     QMap<int, StationMapInfo> result;
     
     // 先查询所有站点，初始化在线状态和库存数量
-    QSqlQuery stationQuery(db);
-    stationQuery.prepare(QStringLiteral("SELECT station_id, status FROM station ORDER BY station_id"));
-    if (stationQuery.exec()) {
+    CachedQuery stationStatement = StatementCache::prepare(db, QStringLiteral("SELECT station_id, status FROM station ORDER BY station_id"));
+    QSqlQuery& stationQuery = *stationStatement;
+    if (StatementCache::exec(stationQuery)) {
         while (stationQuery.next()) {
-            int stationId = stationQuery.value("station_id").toInt();
-            bool isOnline = (stationQuery.value("status").toInt() == 1);
+            int stationId = stationQuery.value(0).toInt();
+            bool isOnline = (stationQuery.value(1).toInt() == 1);
             StationMapInfo info;
             info.isOnline = isOnline;
             info.availableCount = 0;  // 初始化为0
@@ -123,22 +179,22 @@ QMap<int, StationMapInfo> StationDao::selectStationMapInfo(QSqlDatabase& db) {
     }
     
     // 使用聚合查询统计每个站点的可用雨具数量
-    QSqlQuery gearQuery(db);
-    gearQuery.prepare(QStringLiteral(
+    CachedQuery gearStatement = StatementCache::prepare(db, QStringLiteral(
         "SELECT station_id, COUNT(*) as available_count "
         "FROM raingear "
         "WHERE station_id IS NOT NULL AND status = 1 "
         "GROUP BY station_id"
     ));
+    QSqlQuery& gearQuery = *gearStatement;
     
-    if (!gearQuery.exec()) {
+    if (!StatementCache::exec(gearQuery)) {
         qCritical() << "查询站点库存失败:" << gearQuery.lastError().text();
         return result;
     }
     
     while (gearQuery.next()) {
-        int stationId = gearQuery.value("station_id").toInt();
-        int count = gearQuery.value("available_count").toInt();
+        int stationId = gearQuery.value(0).toInt();
+        int count = gearQuery.value(1).toInt();
         if (result.contains(stationId)) {
             result[stationId].availableCount = count;
         }
@@ -152,38 +208,33 @@ QMap<int, StationMapInfo> StationDao::selectStationMapInfo(QSqlDatabase& db) {
 // 管理员后台Part
 // 获取所有站点及其雨具统计
 QVector<StationStatsDTO> StationDao::selectAllWithStats(QSqlDatabase& db) {
+    QueryMetrics::Scope metricsScope("StationDao::selectAllWithStats");
     QVector<StationStatsDTO> result;
     
-    QSqlQuery stationQuery(db);
-    stationQuery.prepare(QStringLiteral("SELECT station_id, name, status FROM station ORDER BY station_id"));
-    if (!stationQuery.exec()) { return result; }
+    // 一条语句按站点透视出各状态数量，由 raingear(station_id, status) 覆盖索引完成计数，不回表，耗时与站点数无关
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "SELECT s.station_id, s.name, s.status, COUNT(g.gear_id), "
+        "COALESCE(SUM(CASE WHEN g.status = 1 THEN 1 ELSE 0 END), 0), "
+        "COALESCE(SUM(CASE WHEN g.status = 2 THEN 1 ELSE 0 END), 0), "
+        "COALESCE(SUM(CASE WHEN g.status = 3 THEN 1 ELSE 0 END), 0), s.version "
+        "FROM station s LEFT JOIN raingear g ON g.station_id = s.station_id "
+        "GROUP BY s.station_id, s.name, s.status, s.version ORDER BY s.station_id"));
+    QSqlQuery& query = *statement;
+    if (!StatementCache::exec(query)) {
+        qWarning() << "查询站点雨具统计失败:" << query.lastError().text();
+        return result;
+    }
     
-    while (stationQuery.next()) {
+    while (query.next()) {
         StationStatsDTO stats;
-        stats.stationId = stationQuery.value("station_id").toInt();
-        stats.name = stationQuery.value("name").toString();
-        stats.isOnline = stationQuery.value("status").toInt() == 1;
-        stats.totalGears = 0;
-        stats.availableCount = 0;
-        stats.borrowedCount = 0;
-        stats.brokenCount = 0;
-        
-        // 查询该站点的雨具统计
-        QSqlQuery gearQuery(db);
-        gearQuery.prepare(QStringLiteral("SELECT status, COUNT(*) as cnt FROM raingear WHERE station_id = ? GROUP BY status"));
-        gearQuery.addBindValue(stats.stationId);
-        if (gearQuery.exec()) {
-            while (gearQuery.next()) {
-                int status = gearQuery.value("status").toInt();
-                int count = gearQuery.value("cnt").toInt();
-                stats.totalGears += count;
-                if (status == 1) stats.availableCount = count;
-                else if (status == 2) stats.borrowedCount = count;
-                else if (status == 3) stats.brokenCount = count;
-            }
-        } else {
-            qWarning() << "查询站点" << stats.stationId << "(" << stats.name << ")的雨具统计失败:" << gearQuery.lastError().text();
-        }
+        stats.stationId = query.value(0).toInt();
+        stats.name = query.value(1).toString();
+        stats.isOnline = query.value(2).toInt() == 1;
+        stats.totalGears = query.value(3).toInt();
+        stats.availableCount = query.value(4).toInt();
+        stats.borrowedCount = query.value(5).toInt();
+        stats.brokenCount = query.value(6).toInt();
+        stats.version = query.value(7).toInt();
         result.append(stats);
     }
     return result;
@@ -191,32 +242,37 @@ QVector<StationStatsDTO> StationDao::selectAllWithStats(QSqlDatabase& db) {
 
 // 获取在线率
 double StationDao::getOnlineRate(QSqlDatabase& db) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT COUNT(*) as total, SUM(CASE WHEN status = 1 THEN 1 ELSE 0 END) as online FROM station"));
-    if (query.exec() && query.next()) {
-        int total = query.value("total").toInt();
-        int online = query.value("online").toInt();
+    QueryMetrics::Scope metricsScope("StationDao::getOnlineRate");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("SELECT COUNT(*) as total, SUM(CASE WHEN status = 1 THEN 1 ELSE 0 END) as online FROM station"));
+    QSqlQuery& query = *statement;
+    if (StatementCache::exec(query) && query.next()) {
+        int total = query.value(0).toInt();
+        int online = query.value(1).toInt();
         if (total > 0) { return (online * 100.0) / total; }
     }
     return 0.0;
 }
 
 // 更新站点在线状态
-bool StationDao::updateStatus(QSqlDatabase& db, int stationId, bool isOnline) {
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("UPDATE station SET status = ? WHERE station_id = ?"));
+WriteResult StationDao::updateStatus(QSqlDatabase& db, int stationId, bool isOnline, int expectedVersion) {
+    QueryMetrics::Scope metricsScope("StationDao::updateStatus");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "UPDATE station SET status = ?, version = version + 1 WHERE station_id = ? AND version = ?"));
+    QSqlQuery& query = *statement;
     query.addBindValue(isOnline ? 1 : 0);
     query.addBindValue(stationId);
+    query.addBindValue(expectedVersion);
     
-    if (!query.exec()) {
+    if (!StatementCache::exec(query)) {
         qCritical() << "更新站点状态失败:" << query.lastError().text();
-        return false;
+        return WriteResult::Error;
     }
     
     if (query.numRowsAffected() == 0) {
-        qWarning() << "更新站点状态：未找到对应的站点ID" << stationId;
-        return false;
+        qWarning() << "更新站点状态：站点不存在或已被修改" << stationId << "version" << expectedVersion;
+        return WriteResult::Conflict;
     }
+    invalidateGate(stationId);
     
-    return true;
+    return WriteResult::Ok;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include"../Model/Stationlocal.h"
 #include"../Model/GlobalEnum.hpp"
+#include"WriteResult.h"
 
 // 站点统计信息DTO，管理员后台用
 struct StationStatsDTO {
@@ -19,6 +20,7 @@ struct StationStatsDTO {
     int availableCount;
     int borrowedCount;
     int brokenCount;
+    int version = 0; // 站点行版本号，修改在线状态时回传
 };
 
 // 站点地图信息DTO，用于地图显示
@@ -27,17 +29,31 @@ struct StationMapInfo {
     bool isOnline;      // 在线状态
 };
 
+// 借还前的站点闸口：在线状态和故障槽位，只读 station 表的一行
+struct StationGate {
+    bool isOnline = false;
+    quint32 faultMask = 0; // 第 n 位为 1 表示槽位 n 故障
+    bool isSlotFaulty(int slotId) const { return slotId > 0 && slotId < 32 && (faultMask & (1u << slotId)); }
+};
+
 class StationDao{
 public:
     // 获取所有站点的完整信息
     std::vector<std::unique_ptr<Stationlocal>> selectAll(QSqlDatabase& db); 
     // 根据站点ID获取站点信息
     std::unique_ptr<Stationlocal> selectById(QSqlDatabase& db, Station station);
+    // 站点闸口（一次主键查询，不加载雨具）；站点不存在或查询失败时为空
+    std::optional<StationGate> selectGate(QSqlDatabase& db, Station station);
+    // 带进程内缓存的闸口查询，maxAgeMs 内复用上次结果；本进程修改站点状态时立即失效，
+    // 其他进程（管理端）的修改最多延迟 maxAgeMs 生效
+    std::optional<StationGate> selectGateCached(QSqlDatabase& db, Station station, int maxAgeMs = GATE_CACHE_MS);
+    static void invalidateGate(int stationId); // 使某个站点的闸口缓存失效
+    static constexpr int GATE_CACHE_MS = 3000;
     //获取各站点的地图信息（库存数量和在线状态，用于地图显示）
     QMap<int, StationMapInfo> selectStationMapInfo(QSqlDatabase& db);
     
     // 管理员Part
     QVector<StationStatsDTO> selectAllWithStats(QSqlDatabase& db); // 获取所有站点及其雨具统计
     double getOnlineRate(QSqlDatabase& db); // 获取在线率
-    bool updateStatus(QSqlDatabase& db, int stationId, bool isOnline); // 更新站点在线状态
+    WriteResult updateStatus(QSqlDatabase& db, int stationId, bool isOnline, int expectedVersion); // 更新站点在线状态，版本号不符时返回 Conflict
 };
\ No newline at end of file
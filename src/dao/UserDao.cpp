@@ -1,61 +1,69 @@
 #include"UserDao.h"
+#include"RowMapper.h"
+#include"../utils/StatementCache.h"
+#include"../utils/QueryMetrics.h"
 
 #include<QSqlQuery>
 #include<QSqlError>
 #include<QDebug>
 #include<QVariant>
 
+// 搜索条件：学号走主键、姓名走 idx_real_name，都只做前缀匹配才能用上索引
+// 关键字里的 % _ 按普通字符处理，转义符用 '!'（MySQL 和 SQLite 对字符串里的反斜杠处理不同）
+static const char* const kSearchCondition = "WHERE user_id LIKE :prefix ESCAPE '!' OR real_name LIKE :prefix ESCAPE '!' ";
+
+static QString likePrefix(const QString& keyword) {
+    QString escaped = keyword;
+    escaped.replace(QLatin1Char('!'), QStringLiteral("!!"));
+    escaped.replace(QLatin1Char('%'), QStringLiteral("!%"));
+    escaped.replace(QLatin1Char('_'), QStringLiteral("!_"));
+    return escaped + QLatin1Char('%');
+}
+
 // select_by_id
 std::optional<User> UserDao::selectById(QSqlDatabase& db, const QString& id){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT user_id, real_name, password, role, credit, is_active "
-    "FROM users WHERE user_id = :uid LIMIT 1")); //查到一个就不再继续往下查了，id是唯一的
+    QueryMetrics::Scope metricsScope("UserDao::selectById");
+    static const QString sql = RowMapper<User>::select(QStringLiteral("WHERE user_id = :uid LIMIT 1")); //查到一个就不再继续往下查了，id是唯一的
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.bindValue(":uid", id); //绑定参数，避免sql注入
-    if(!query.exec()){
+    if(!StatementCache::exec(query)){
         qWarning() << "[UserDao::selectById] Error: " << query.lastError().text();
         return std::nullopt;
     }
     if(query.next()){
-        return User(query.value("user_id").toString(), 
-                    query.value("real_name").toString(), 
-                    query.value("password").toString(), 
-                    query.value("role").toInt(), 
-                    query.value("credit").toDouble(), 
-                    query.value("is_active").toBool());
+        return RowMapper<User>::read(query);
     }
     return std::nullopt;
 }
 
 // select_by_id_and_name
 std::optional<User> UserDao::selectByIdAndName(QSqlDatabase& db, const QString& id, const QString& name){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("SELECT user_id, real_name, password, role, credit, is_active "
-    "FROM users WHERE user_id = :uid AND real_name = :name LIMIT 1"));
+    QueryMetrics::Scope metricsScope("UserDao::selectByIdAndName");
+    static const QString sql = RowMapper<User>::select(QStringLiteral("WHERE user_id = :uid AND real_name = :name LIMIT 1"));
+    CachedQuery statement = StatementCache::prepare(db, sql);
+    QSqlQuery& query = *statement;
     query.bindValue(":uid",id);
     query.bindValue(":name",name);
-    if(!query.exec()){
+    if(!StatementCache::exec(query)){
         qWarning() << "[UserDao::selectByIdAndName] Error: " << query.lastError().text();
         return std::nullopt;
     }
     if(query.next()){
-        return User(query.value("user_id").toString(), 
-                    query.value("real_name").toString(), 
-                    query.value("password").toString(), 
-                    query.value("role").toInt(), 
-                    query.value("credit").toDouble(), 
-                    query.value("is_active").toBool());
+        return RowMapper<User>::read(query);
     }
     return std::nullopt;
 }
 
 // update_password
 bool UserDao::updatePassword(QSqlDatabase& db, const QString& id, const QString& name,const QString& newPassword){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("UPDATE users SET password = :newpwd, is_active = 1 WHERE user_id = :uid AND real_name = :name"));
+    QueryMetrics::Scope metricsScope("UserDao::updatePassword");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("UPDATE users SET password = :newpwd, is_active = 1 WHERE user_id = :uid AND real_name = :name"));
+    QSqlQuery& query = *statement;
     query.bindValue(":newpwd",newPassword);
     query.bindValue(":uid",id);
     query.bindValue(":name",name);
-    if(!query.exec()){
+    if(!StatementCache::exec(query)){
         qWarning() << "[UserDao::updatePassword] Error: " << query.lastError().text();
         return false;
     }
@@ -64,31 +72,102 @@ bool UserDao::updatePassword(QSqlDatabase& db, const QString& id, const QString&
 
 // update_balance
 bool UserDao::updateBalance(QSqlDatabase& db, const QString& id,double amountchange){
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral("UPDATE users SET credit = credit + :amount WHERE user_id = :uid"));
+    QueryMetrics::Scope metricsScope("UserDao::updateBalance");
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral("UPDATE users SET credit = credit + :amount WHERE user_id = :uid"));
+    QSqlQuery& query = *statement;
     query.bindValue(":amount",amountchange);
     query.bindValue(":uid",id);
-    if(!query.exec()){
+    if(!StatementCache::exec(query)){
         qWarning() << "[UserDao::updateBalance] Error: " << query.lastError().text();
         return false;
     }
     return true;
 }
 
-// select_all
-QVector<User> UserDao::selectAll(QSqlDatabase& db){
-    QVector<User> users;
-    QSqlQuery query(db);
-    query.prepare(QStringLiteral(
-        "SELECT user_id, real_name, password, role, credit, is_active "
-        "FROM users ORDER BY user_id"
-    ));
-    if(!query.exec()){
-        qWarning() << "[UserDao::selectAll] Error: " << query.lastError().text();
-        return users;
+// 借伞记账
+bool UserDao::openBorrow(QSqlDatabase& db, const QString& id, qint64 recordId, double deposit, bool* ok){
+    QueryMetrics::Scope metricsScope("UserDao::openBorrow");
+    if(ok) *ok = false;
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "UPDATE users SET credit = credit - :amount, open_record_id = :rid "
+        "WHERE user_id = :uid AND is_active = 1 AND open_record_id IS NULL AND credit >= :required"));
+    QSqlQuery& query = *statement;
+    query.bindValue(":amount", deposit);
+    query.bindValue(":rid", recordId);
+    query.bindValue(":uid", id);
+    query.bindValue(":required", deposit);
+    if(!StatementCache::exec(query)){
+        qWarning() << "[UserDao::openBorrow] Error: " << query.lastError().text();
+        return false;
     }
-    while(query.next()){
-        users.append(User(query.value("user_id").toString(), query.value("real_name").toString(), query.value("password").toString(), query.value("role").toInt(), query.value("credit").toDouble(), query.value("is_active").toBool()));
+    if(ok) *ok = true;
+    return query.numRowsAffected() == 1;
+}
+
+// 还伞记账
+bool UserDao::closeBorrow(QSqlDatabase& db, const QString& id, qint64 recordId, double refund, bool* ok){
+    QueryMetrics::Scope metricsScope("UserDao::closeBorrow");
+    if(ok) *ok = false;
+    CachedQuery statement = StatementCache::prepare(db, QStringLiteral(
+        "UPDATE users SET credit = credit + :refund, open_record_id = NULL WHERE user_id = :uid AND open_record_id = :rid"));
+    QSqlQuery& query = *statement;
+    query.bindValue(":refund", refund);
+    query.bindValue(":uid", id);
+    query.bindValue(":rid", recordId);
+    if(!StatementCache::exec(query)){
+        qWarning() << "[UserDao::closeBorrow] Error: " << query.lastError().text();
+        return false;
     }
+    if(ok) *ok = true;
+    return query.numRowsAffected() == 1;
+}
+
+// 管理员后台Part
+// 搜索用户（分页），只查列表需要的列
+QVector<UserInfoDTO> UserDao::searchDTO(QSqlDatabase& db, const QString& keyword, int limit, int offset){
+    QueryMetrics::Scope metricsScope("UserDao::searchDTO");
+    QVector<UserInfoDTO> users;
+    static const QString allSql = RowMapper<UserInfoDTO>::select(QStringLiteral("ORDER BY user_id LIMIT :limit OFFSET :offset"));
+    static const QString searchSql = RowMapper<UserInfoDTO>::select(QLatin1String(kSearchCondition)
+        + QStringLiteral("ORDER BY user_id LIMIT :limit OFFSET :offset"));
+    CachedQuery statement = StatementCache::prepare(db, keyword.isEmpty() ? allSql : searchSql);
+    QSqlQuery& query = *statement;
+    if(!keyword.isEmpty()){ query.bindValue(":prefix", likePrefix(keyword)); }
+    query.bindValue(":limit", limit);
+    query.bindValue(":offset", qMax(0, offset));
+    if(!StatementCache::exec(query)){
+        qWarning() << "[UserDao::searchDTO] Error: " << query.lastError().text();
+        return users;
+    }
+    users.reserve(limit);
+    RowMapper<UserInfoDTO>::readAll(query, users);
     return users;
 }
+
+// 统计搜索结果总数
+int UserDao::countSearch(QSqlDatabase& db, const QString& keyword){
+    QueryMetrics::Scope metricsScope("UserDao::countSearch");
+    static const QString allSql = QStringLiteral("SELECT COUNT(*) FROM users");
+    static const QString searchSql = QStringLiteral("SELECT COUNT(*) FROM users ") + QLatin1String(kSearchCondition);
+    CachedQuery statement = StatementCache::prepare(db, keyword.isEmpty() ? allSql : searchSql);
+    QSqlQuery& query = *statement;
+    if(!keyword.isEmpty()){ query.bindValue(":prefix", likePrefix(keyword)); }
+    if(StatementCache::exec(query) && query.next()){
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+// 按一批ID查询用户（分组 IN 查询）
+QHash<QString, UserInfoDTO> UserDao::selectDTOByIds(QSqlDatabase& db, const QVector<QString>& ids){
+    QueryMetrics::Scope metricsScope("UserDao::selectDTOByIds");
+    return RowMapper<UserInfoDTO>::selectIn(db, "user_id", ids, [](const UserInfoDTO& user){ return user.userId; });
+}
+
+// 流式读取全部用户
+StreamResult UserDao::streamDTO(QSqlDatabase& db, const std::function<bool(const UserInfoDTO&)>& visitor,
+                                const CancelToken& token){
+    QueryMetrics::Scope metricsScope("UserDao::streamDTO");
+    return RowMapper<UserInfoDTO>::stream(db, "user_id", QString(), QVariantList(),
+                                          [](const UserInfoDTO& user){ return user.userId; }, visitor, token);
+}
@@ -3,12 +3,25 @@
 #include<QSqlDatabase>
 #include<QSqlQuery>
 #include<QVector>
+#include<QHash>
+#include<functional>
 #include<optional>
 #include<QString>
 
 #include"../utils/ConnectionPool.h"
+#include"../utils/DbExecutor.h"
+#include"PageCursor.h"
 #include"../model/User.h"
 
+// 用户信息DTO，管理员后台列表用（不含密码列）
+struct UserInfoDTO {
+    QString userId;
+    QString realName;
+    int role;
+    double credit;
+    bool isActive;
+};
+
 class UserDao{
 public:
     // 根据ID查询用户
@@ -19,7 +32,21 @@ public:
     bool updatePassword(QSqlDatabase& db, const QString& id, const QString& name,const QString& newPassword);
     // 更新余额，正负数都ok
     bool updateBalance(QSqlDatabase& db, const QString& id,double amountchange);
-    // 获取所有用户
-    QVector<User> selectAll(QSqlDatabase& db);
+    // 借伞记账：一条条件 UPDATE 扣押金并把 open_record_id 指向新订单，只有用户已激活、没有未归还订单
+    // 且余额不少于 deposit（> 0）时才生效；返回是否生效，ok 返回语句是否执行成功。一人一单由这里保证
+    bool openBorrow(QSqlDatabase& db, const QString& id, qint64 recordId, double deposit, bool* ok = nullptr);
+    // 还伞记账：退款并清空 open_record_id，只有指针仍指向 recordId 时才生效，同一订单不会退两次款
+    bool closeBorrow(QSqlDatabase& db, const QString& id, qint64 recordId, double refund, bool* ok = nullptr);
+    
+    // 管理员后台Part
+    // 按学号/工号前缀或姓名前缀搜索用户（keyword 为空时不过滤），按学号排序分页
+    QVector<UserInfoDTO> searchDTO(QSqlDatabase& db, const QString& keyword, int limit, int offset = 0);
+    // 与 searchDTO 条件相同的总数（用于分页）
+    int countSearch(QSqlDatabase& db, const QString& keyword);
+    // 按一批ID查询用户（不含密码列），不存在的ID不出现在结果中
+    QHash<QString, UserInfoDTO> selectDTOByIds(QSqlDatabase& db, const QVector<QString>& ids);
+    // 流式读取全部用户（按 user_id 升序，分块取回，不含密码列），visitor 返回 false 时停止
+    StreamResult streamDTO(QSqlDatabase& db, const std::function<bool(const UserInfoDTO&)>& visitor,
+                           const CancelToken& token = CancelToken());
 };
 
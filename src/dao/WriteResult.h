@@ -0,0 +1,13 @@
+/*
+  带版本号的条件写入结果。
+  raingear、station 表带 version 列，每次写入都 version + 1；更新语句带上调用方读到的版本号（WHERE version = ?），
+  读到之后被别的终端改过就一行也不更新，返回 Conflict，由 Service 提示刷新后重试，而不是静默覆盖别人的修改。
+ */
+
+#pragma once
+
+enum class WriteResult {
+    Ok,       // 已更新
+    Conflict, // 版本号不符（被其他终端修改过或已删除），未更新
+    Error     // 语句执行失败
+};
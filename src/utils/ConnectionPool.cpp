@@ -3,43 +3,558 @@
 #include<QDebug>
 #include<QString>
 #include<QSqlError>
+#include<QSqlRecord>
+#include<QVariant>
 #include<QThread>
+#include<QElapsedTimer>
+#include<QDeadlineTimer>
+#include<QMutexLocker>
+#include<algorithm>
 
 #include "ConnectionPool.h"
+#include "StatementCache.h"
 
-QSqlDatabase ConnectionPool::getThreadLocalConnection(){
-    // 根据线程ID生成唯一的连接名，不用改
-    QString connectionName=QString("Conn_%1").arg((quint64)QThread::currentThreadId());
-    
-    if(QSqlDatabase::contains(connectionName)){
-        return QSqlDatabase::database(connectionName);
+namespace {
+// 单调时钟，用于记录连接空闲时长
+qint64 monotonicMs(){
+    static QElapsedTimer clock = [](){ QElapsedTimer t; t.start(); return t; }();
+    return clock.elapsed();
+}
+
+// QSqlDatabase 的驱动对象有线程归属，跨线程借出时需要先"推"到无归属状态，再由使用方线程"拉"过来
+// Qt 6.8 之前没有 QSqlDatabase::moveToThread，只能依赖驱动本身不检查线程
+void detachFromThread(QSqlDatabase& db){
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    db.moveToThread(nullptr);
+#else
+    Q_UNUSED(db);
+#endif
+}
+
+void attachToCurrentThread(QSqlDatabase& db){
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    if(!db.moveToThread(QThread::currentThread())){
+        qWarning() << "[ConnectionPool] 连接切换线程失败:" << db.connectionName();
+    }
+#else
+    Q_UNUSED(db);
+#endif
+}
+}
+
+// ConnectionLease
+
+ConnectionLease::~ConnectionLease(){
+    release();
+}
+
+ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept : conn(other.conn){
+    other.conn = nullptr;
+}
+
+ConnectionLease& ConnectionLease::operator=(ConnectionLease&& other) noexcept{
+    if(this != &other){
+        release();
+        conn = other.conn;
+        other.conn = nullptr;
+    }
+    return *this;
+}
+
+void ConnectionLease::release(){
+    if(conn){
+        conn->owner->releaseImpl(conn);
+        conn = nullptr;
+    }
+}
+
+// ConnectionPool
+
+PoolConfig& ConnectionPool::pendingConfig(){
+    static PoolConfig config;
+    return config;
+}
+
+// 连接池在进程内常驻，不在静态析构阶段销毁，避免与 QSqlDatabase 全局注册表的析构顺序冲突
+ConnectionPool* ConnectionPool::create(const PoolConfig& config, bool replica){
+    auto* p = new ConnectionPool();
+    p->settings = config;
+    p->isReplica = replica;
+    p->namePrefix = replica ? QStringLiteral("RainHub_Replica") : QStringLiteral("RainHub_Pool");
+    if(replica){
+        p->settings.hostName = config.replicaHostName;
+        p->settings.port = config.replicaPort;
+    }
+    p->settings.maxConnections = std::max(1, p->settings.maxConnections);
+    p->settings.minConnections = std::clamp(p->settings.minConnections, 0, p->settings.maxConnections);
+    p->warmUp();
+    return p;
+}
+
+ConnectionPool& ConnectionPool::instance(){
+    static ConnectionPool* pool = [](){
+        SqlDialect::setBackend(pendingConfig().backend);
+        return create(pendingConfig(), false);
+    }();
+    return *pool;
+}
+
+ConnectionPool* ConnectionPool::replicaInstance(){
+    static ConnectionPool* pool = []() -> ConnectionPool* {
+        const PoolConfig& config = instance().settings; // 确保主库先初始化
+        if(config.backend != DbBackend::MySql || config.replicaHostName.isEmpty()) return nullptr;
+        return create(config, true);
+    }();
+    return pool;
+}
+
+namespace {
+QAtomicInteger<quint64> replicaReadCount = 0;
+QAtomicInteger<quint64> replicaFallbackCount = 0;
+}
+
+void ConnectionPool::configure(const PoolConfig& config){
+    pendingConfig() = config;
+}
+
+ConnectionLease ConnectionPool::acquire(int timeoutMs){
+    return instance().acquireImpl(timeoutMs);
+}
+
+// 只读请求：副本可用且复制延迟在允许范围内时走副本，否则回退主库
+ConnectionLease ConnectionPool::acquire(DbAccess access, int timeoutMs){
+    if(access == DbAccess::ReadOnly){
+        if(ConnectionPool* replica = replicaInstance()){
+            // 副本只短暂等待，等满整个超时再回退会让只读请求最多耗时两倍超时
+            int replicaWaitMs = replica->settings.replicaAcquireWaitMs;
+            if(timeoutMs >= 0) replicaWaitMs = qMin(replicaWaitMs, timeoutMs);
+            ConnectionLease lease = replica->acquireImpl(replicaWaitMs);
+            if(lease && replica->replicaLagAcceptable(*lease)){
+                replicaReadCount.fetchAndAddRelaxed(1);
+                return lease;
+            }
+            replicaFallbackCount.fetchAndAddRelaxed(1);
+        }
+    }
+    return instance().acquireImpl(timeoutMs);
+}
+
+PoolStats ConnectionPool::statsImpl(){
+    QMutexLocker locker(&mutex);
+    PoolStats s;
+    s.totalConnections = static_cast<int>(connections.size());
+    s.idleConnections = idle.size();
+    s.inUseConnections = s.totalConnections - s.idleConnections;
+    s.waitingThreads = static_cast<int>(waiters.size());
+    s.acquireTimeouts = acquireTimeouts;
+    s.rejectedRequests = rejectedRequests;
+    s.connectionsOpened = connectionsOpened;
+    s.connectionsReclaimed = connectionsReclaimed;
+    s.health = healthState;
+    return s;
+}
+
+PoolStats ConnectionPool::stats(){
+    PoolStats s = instance().statsImpl();
+    s.replicaReads = replicaReadCount.loadRelaxed();
+    s.replicaFallbacks = replicaFallbackCount.loadRelaxed();
+    return s;
+}
+
+PoolStats ConnectionPool::replicaStats(){
+    ConnectionPool* replica = replicaInstance();
+    return replica ? replica->statsImpl() : PoolStats();
+}
+
+int ConnectionPool::capacity(){
+    return instance().settings.maxConnections;
+}
+
+PoolConfig ConnectionPool::configured(){
+    return pendingConfig();
+}
+
+PoolConfig ConnectionPool::config(){
+    return instance().settings;
+}
+
+DbHealth ConnectionPool::health(){
+    ConnectionPool& pool = instance();
+    QMutexLocker locker(&pool.mutex);
+    return pool.healthState;
+}
+
+DbHealth ConnectionPool::ping(){
+    if(ConnectionPool* replica = replicaInstance()) replica->reclaimIdleImpl();
+    return instance().pingImpl();
+}
+
+int ConnectionPool::reclaimIdle(){
+    int reclaimed = instance().reclaimIdleImpl();
+    if(ConnectionPool* replica = replicaInstance()) reclaimed += replica->reclaimIdleImpl();
+    return reclaimed;
+}
+
+void ConnectionPool::setHealthListener(std::function<void(DbHealth)> listener){
+    ConnectionPool& pool = instance();
+    QMutexLocker locker(&pool.mutex);
+    pool.healthListener = std::move(listener);
+}
+
+// 预建 minConnections 个连接，避免第一次借伞时才去握手
+void ConnectionPool::warmUp(){
+    for(int i = 0; i < settings.minConnections; ++i){
+        {
+            QMutexLocker locker(&mutex);
+            ++pendingCreates;
+        }
+        PooledConnection* conn = createConnection();
+        if(!conn) break;
+        detachFromThread(conn->db);
+        QMutexLocker locker(&mutex);
+        idle.append(conn);
+    }
+}
+
+ConnectionLease ConnectionPool::acquireImpl(int timeoutMs){
+    if(timeoutMs < 0) timeoutMs = settings.acquireTimeoutMs;
+    QDeadlineTimer deadline(timeoutMs);
+
+    PooledConnection* conn = nullptr;
+    bool probe = false;
+    {
+        QMutexLocker locker(&mutex);
+        if(circuitOpen){
+            // 熔断期间直接失败；冷却结束后只放行一个调用方去探测
+            if(probing || monotonicMs() < nextProbeMs){
+                ++rejectedRequests;
+                return ConnectionLease();
+            }
+            probing = probe = true;
+        }
+        if(!idle.isEmpty()){
+            conn = idle.takeLast();
+        }else if(static_cast<int>(connections.size()) + pendingCreates < settings.maxConnections){
+            ++pendingCreates; // 先占名额，在锁外握手
+        }else{
+            // 池已满，排队等待其他线程归还
+            Waiter waiter;
+            waiters.push_back(&waiter);
+            while(!waiter.handed){
+                if(!waiter.cond.wait(&mutex, deadline)) break;
+            }
+            if(!waiter.handed){
+                waiters.erase(std::find(waiters.begin(), waiters.end(), &waiter));
+                ++acquireTimeouts;
+                if(probe) probing = false;
+                qWarning() << "[ConnectionPool] 等待数据库连接超时(" << timeoutMs << "ms)";
+                return ConnectionLease();
+            }
+            conn = waiter.handed;
+        }
+    }
+
+    if(!conn){
+        conn = createConnection();
+        if(!conn) return ConnectionLease();
+    }else{
+        attachToCurrentThread(conn->db);
+        if(!validate(conn, probe)){
+            releaseImpl(conn);
+            return ConnectionLease();
+        }
+    }
+    StatementCache::clearLastError();
+    return ConnectionLease(conn);
+}
+
+void ConnectionPool::releaseImpl(PooledConnection* conn){
+    // 使用期间遇到断线（数据库重启、wait_timeout 等），其他连接多半也已失效，全部标记为借出前先 ping
+    if(SqlDialect::isConnectionLostError(StatementCache::lastError())){
+        StatementCache::clearLastError();
+        conn->epoch = epoch.fetchAndAddRelaxed(1);
+    }
+    detachFromThread(conn->db);
+    QMutexLocker locker(&mutex);
+    conn->lastReleasedMs = conn->lastUsedMs = monotonicMs();
+    if(!waiters.empty()){
+        Waiter* waiter = waiters.front();
+        waiters.pop_front();
+        waiter->handed = conn;
+        waiter->cond.wakeOne();
+        return;
+    }
+    idle.append(conn);
+}
+
+// 探测不是真正的使用：只刷新"确认可用"的时间，lastUsedMs 不变，并按 lastUsedMs 插回原来的位置，
+// 否则每次探测都把最旧的连接挪到队尾，空闲连接永远达不到 idleTimeoutMs，回收就失效了
+void ConnectionPool::returnPinged(PooledConnection* conn){
+    detachFromThread(conn->db);
+    QMutexLocker locker(&mutex);
+    if(!waiters.empty()){
+        Waiter* waiter = waiters.front();
+        waiters.pop_front();
+        waiter->handed = conn;
+        waiter->cond.wakeOne();
+        return;
+    }
+    auto pos = std::find_if(idle.begin(), idle.end(),
+                            [conn](PooledConnection* c){ return c->lastUsedMs > conn->lastUsedMs; });
+    idle.insert(pos, conn);
+}
+
+// 创建并打开一个新连接，调用前需已在 pendingCreates 中占好名额
+PooledConnection* ConnectionPool::createConnection(){
+    auto conn = std::make_unique<PooledConnection>();
+    {
+        QMutexLocker locker(&mutex);
+        conn->owner = this;
+        conn->name = QStringLiteral("%1_%2").arg(namePrefix).arg(nextConnectionId++);
+    }
+    conn->db = QSqlDatabase::addDatabase(SqlDialect::driverName(settings.backend), conn->name);
+    if(settings.backend == DbBackend::Sqlite){
+        if(settings.databaseName == QLatin1String(":memory:")){
+            // 普通 :memory: 每个连接各是一个独立的库，用共享缓存的内存库让池中所有连接看到同一份数据
+            conn->db.setDatabaseName(QStringLiteral("file:rainhub_memdb?mode=memory&cache=shared"));
+            conn->db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_URI"));
+        }else{
+            conn->db.setDatabaseName(settings.databaseName);
+        }
+    }else{
+        conn->db.setHostName(settings.hostName);
+        conn->db.setPort(settings.port);
+        conn->db.setDatabaseName(settings.databaseName);
+        conn->db.setUserName(settings.userName);
+        conn->db.setPassword(settings.password);
+        conn->db.setConnectOptions(QStringLiteral("MYSQL_OPT_CONNECT_TIMEOUT=%1").arg(settings.connectTimeoutSec));
+    }
+
+    bool opened = openConnection(conn.get());
+
+    QMutexLocker locker(&mutex);
+    --pendingCreates;
+    if(!opened){
+        QString name = conn->name;
+        conn->db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+        return nullptr;
+    }
+    conn->lastReleasedMs = conn->lastUsedMs = monotonicMs();
+    ++connectionsOpened;
+    connections.push_back(std::move(conn));
+    return connections.back().get();
+}
+
+bool ConnectionPool::openConnection(PooledConnection* conn){
+    QSqlDatabase& db = conn->db;
+    if(!db.open()){
+        qCritical()<<"Failed to connect to database: "<<db.lastError().text();
+        recordConnectResult(false);
+        return false;
+    }
+    qInfo()<<"Connected to database: "<<db.databaseName()<<"("<<conn->name<<")";
+    conn->epoch = epoch.loadRelaxed();
+    recordConnectResult(true);
+
+    // 会话初始化（MySQL 设置时区，SQLite 打开外键和忙等待）
+    QSqlQuery initQuery(db);
+    for(const QString& sql : SqlDialect::sessionInitStatements()){
+        if(!initQuery.exec(sql)){
+            qWarning() << "会话初始化失败:" << sql << initQuery.lastError().text();
+        }
+    }
+    // 副本连接只读，标错用途的写操作会被数据库直接拒绝，而不是悄悄写到副本上
+    if(isReplica && !initQuery.exec(QStringLiteral("SET SESSION TRANSACTION READ ONLY"))){
+        qWarning() << "副本会话只读设置失败:" << initQuery.lastError().text();
+    }
+    // 内嵌后端没有单独的初始化脚本，建表语句都是 IF NOT EXISTS，每个连接打开时执行一次即可
+    for(const QString& sql : SqlDialect::schemaStatements()){
+        if(!initQuery.exec(sql)){
+            qCritical() << "建表失败:" << sql << initQuery.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+// 借出前的健康检查：只对空闲过久、已断开或熔断/断线后还没确认过的连接执行，失效则原地重连；force 时总是检查
+bool ConnectionPool::validate(PooledConnection* conn, bool force){
+    QSqlDatabase& db = conn->db;
+    bool idleTooLong = monotonicMs() - conn->lastReleasedMs > settings.validateAfterIdleMs;
+    bool stale = conn->epoch != epoch.loadRelaxed();
+    if(db.isOpen() && !idleTooLong && !stale && !force) return true;
+
+    if(db.isOpen()){
+        QSqlQuery ping(db);
+        if(ping.exec(QStringLiteral("SELECT 1"))){
+            conn->epoch = epoch.loadRelaxed();
+            recordConnectResult(true);
+            return true;
+        }
+        qWarning() << "[ConnectionPool] 连接" << conn->name << "已失效，尝试重连:" << ping.lastError().text();
+    }
+    StatementCache::invalidate(db); // 旧会话上的预编译语句在重连后全部失效
+    if(db.isOpen()){
+        db.close();
+    }
+    return openConnection(conn);
+}
+
+DbHealth ConnectionPool::pingImpl(){
+    reclaimIdleImpl(); // 先回收，避免去 ping 马上要关闭的连接
+    PooledConnection* conn = nullptr;
+    bool create = false;
+    {
+        QMutexLocker locker(&mutex);
+        bool probe = false;
+        if(circuitOpen){
+            if(probing || monotonicMs() < nextProbeMs) return healthState;
+            probing = probe = true;
+        }
+        if(!idle.isEmpty()){
+            // 最久没确认过的连接，顺带保活，避免被服务端 wait_timeout 断开；各空闲连接轮流被探测
+            auto oldest = std::min_element(idle.begin(), idle.end(), [](PooledConnection* a, PooledConnection* b){
+                return a->lastReleasedMs < b->lastReleasedMs;
+            });
+            conn = *oldest;
+            idle.erase(oldest);
+        }else if(probe && static_cast<int>(connections.size()) + pendingCreates < settings.maxConnections){
+            ++pendingCreates;
+            create = true;
+        }else{
+            if(probe) probing = false;
+            return healthState; // 连接都在使用中，由使用方自己发现问题
+        }
+    }
+
+    if(create){
+        conn = createConnection();
+        if(conn) releaseImpl(conn);
     }else{
-        QSqlDatabase db=QSqlDatabase::addDatabase("QMYSQL",connectionName);
-        db.setHostName("127.0.0.1");
-        db.setPort(3306);
-        db.setDatabaseName("rainhub_db"); 
-        db.setUserName("root"); 
-        db.setPassword("root"); 
-        
-        if(!db.open()){
-            qCritical()<<"Failed to connect to database: "<<db.lastError().text();
+        attachToCurrentThread(conn->db);
+        if(validate(conn, true)) conn->lastReleasedMs = monotonicMs();
+        returnPinged(conn);
+    }
+
+    QMutexLocker locker(&mutex);
+    return healthState;
+}
+
+// 回收空闲过久的多余连接：idle 按最近一次使用的时间从旧到新排列，从队头开始检查，保留至少 minConnections 个连接
+int ConnectionPool::reclaimIdleImpl(){
+    if(settings.idleTimeoutMs <= 0) return 0;
+    // 共享缓存的内存库在最后一个连接关闭时就会被销毁，至少保留一个连接
+    const bool memoryDb = settings.backend == DbBackend::Sqlite && settings.databaseName == QLatin1String(":memory:");
+    const int keep = memoryDb ? std::max(1, settings.minConnections) : settings.minConnections;
+
+    std::vector<std::unique_ptr<PooledConnection>> expired;
+    {
+        QMutexLocker locker(&mutex);
+        const qint64 now = monotonicMs();
+        while(!idle.isEmpty() && static_cast<int>(connections.size()) > keep
+              && now - idle.first()->lastUsedMs > settings.idleTimeoutMs){
+            PooledConnection* conn = idle.takeFirst();
+            auto it = std::find_if(connections.begin(), connections.end(),
+                                   [conn](const std::unique_ptr<PooledConnection>& c){ return c.get() == conn; });
+            expired.push_back(std::move(*it));
+            connections.erase(it);
+        }
+        connectionsReclaimed += expired.size();
+    }
+
+    for(auto& conn : expired){
+        attachToCurrentThread(conn->db);
+        StatementCache::invalidate(conn->db); // 驱动对象即将销毁，先丢弃挂在它上面的预编译语句
+        conn->db.close();
+        const QString name = conn->name;
+        conn->db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+    if(!expired.empty()){
+        qInfo() << "[ConnectionPool] 回收空闲连接" << expired.size() << "个，剩余" << statsImpl().totalConnections;
+    }
+    return static_cast<int>(expired.size());
+}
+
+// 熔断器：连续失败达到阈值后熔断并按指数退避设置冷却时间，任意一次成功即恢复
+void ConnectionPool::recordConnectResult(bool ok){
+    std::function<void(DbHealth)> listener;
+    DbHealth state;
+    int cooldownMs = 0;
+    {
+        QMutexLocker locker(&mutex);
+        DbHealth before = healthState;
+        if(ok){
+            consecutiveFailures = 0;
+            backoffMs = 0;
+            circuitOpen = false;
+            probing = false;
+            healthState = DbHealth::Healthy;
         }else{
-            qInfo()<<"Connected to database: "<<db.databaseName();
-            
-            QSqlQuery timezoneQuery(db);
-            if (!timezoneQuery.exec("SET time_zone = '+8:00'")) {
-                 qWarning() << "设置时区失败:" << timezoneQuery.lastError().text();
-            } else {
-                 qInfo() << "数据库时区已强制设置为: +8:00";
+            ++consecutiveFailures;
+            if(circuitOpen || consecutiveFailures >= settings.failureThreshold){
+                if(!circuitOpen) epoch.fetchAndAddRelaxed(1); // 恢复后旧连接全部先 ping 再用
+                backoffMs = circuitOpen ? qMin(backoffMs * 2, settings.maxReconnectBackoffMs)
+                                        : settings.reconnectBackoffMs;
+                circuitOpen = true;
+                probing = false;
+                nextProbeMs = monotonicMs() + backoffMs;
+                healthState = DbHealth::Down;
+            }else{
+                healthState = DbHealth::Degraded;
             }
         }
-        return db;
+        if(healthState == before) return;
+        state = healthState;
+        cooldownMs = backoffMs;
+        listener = healthListener;
+    }
+
+    switch(state){
+        case DbHealth::Healthy:  qInfo() << "[ConnectionPool] 数据库连接已恢复"; break;
+        case DbHealth::Degraded: qWarning() << "[ConnectionPool] 数据库连接不稳定"; break;
+        case DbHealth::Down:     qWarning() << "[ConnectionPool] 数据库不可用，熔断" << cooldownMs << "ms 后重试"; break;
     }
+    if(listener) listener(state);
 }
 
-void ConnectionPool::removeThreadConnection(){
-    QString connectionName=QString("Conn_%1").arg((quint64)QThread::currentThreadId());
-    if(QSqlDatabase::contains(connectionName)){
-        QSqlDatabase::removeDatabase(connectionName);
+// 复制延迟检查：按 replicaLagCheckMs 间隔在借出的副本连接上查一次复制状态，期间复用上次的结论
+bool ConnectionPool::replicaLagAcceptable(QSqlDatabase& db){
+    qint64 now = monotonicMs();
+    if(now < lagCheckDueMs.loadRelaxed()) return lagOk.loadRelaxed() != 0;
+    lagCheckDueMs.storeRelaxed(now + settings.replicaLagCheckMs);
+
+    bool ok = true;
+    QString detail;
+    QSqlQuery query(db);
+    // MySQL 8.0.22 起为 SHOW REPLICA STATUS，更早的版本只认 SHOW SLAVE STATUS
+    if(query.exec(QStringLiteral("SHOW REPLICA STATUS")) || query.exec(QStringLiteral("SHOW SLAVE STATUS"))){
+        if(query.next()){
+            QSqlRecord record = query.record();
+            int column = record.indexOf(QStringLiteral("Seconds_Behind_Source"));
+            if(column < 0) column = record.indexOf(QStringLiteral("Seconds_Behind_Master"));
+            QVariant lag = column >= 0 ? query.value(column) : QVariant();
+            if(lag.isNull()){
+                ok = false; // 复制线程未运行
+                detail = QStringLiteral("replication stopped");
+            }else{
+                ok = lag.toInt() <= settings.maxReplicaLagSec;
+                detail = QStringLiteral("lag %1s").arg(lag.toInt());
+            }
+        }else{
+            ok = false; // 没有复制状态：地址配成了主库或其他实例，或执行过 RESET REPLICA ALL，数据不可信
+            detail = QStringLiteral("not a replica");
+        }
+    }else{
+        ok = false;
+        detail = query.lastError().text();
+    }
+
+    bool previous = lagOk.fetchAndStoreRelaxed(ok ? 1 : 0) != 0;
+    if(previous != ok){
+        if(ok) qInfo() << "[ConnectionPool] 只读副本恢复使用:" << detail;
+        else qWarning() << "[ConnectionPool] 只读副本暂停使用，只读请求回退主库:" << detail;
     }
-}
\ No newline at end of file
+    return ok;
+}
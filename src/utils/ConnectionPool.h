@@ -1,14 +1,194 @@
 /*
   数据库连接池类，用于管理数据库连接，避免频繁创建和销毁连接，提高性能。
-  其实就是一个静态工具类
+  池中连接数量在 [minConnections, maxConnections] 之间，任何线程都可以通过 acquire() 借出一个连接租约，
+  租约析构时连接自动归还；池满时调用方进入等待队列（先到先得），超时后拿到的是无效租约。
+  借出连接时会对空闲过久的连接做一次 SELECT 1 健康检查，失效则重连。
+  连接不与线程绑定，线程退出不会遗留连接；超出 minConnections 的部分空闲超过 idleTimeoutMs 后由后台探测顺带关闭回收。
+  连接连续失败达到阈值后熔断：熔断期间 acquire() 立即返回无效租约，不再每次都卡在驱动的连接超时上；
+  冷却时间按指数退避增长，冷却结束后只放行一个调用方（或后台探测）去重连，成功即恢复。
+  配置了只读副本时另建一个副本连接池：acquire(DbAccess::ReadOnly) 优先从副本借连接，
+  副本不可用、复制延迟超过 maxReplicaLagSec、或副本连接全部借出且 replicaAcquireWaitMs 内没有归还时回退到主库，
+  完整的 acquireTimeoutMs 只用在主库上。副本连接的会话设为只读，误写会直接报错。
  */
 
 #pragma once
 
 #include <QSqlDatabase>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <QVector>
+#include <QAtomicInteger>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "SqlDialect.h"
+
+// 连接池配置，需在第一次 acquire() 之前通过 ConnectionPool::configure() 设置
+struct PoolConfig {
+    DbBackend backend = DbBackend::MySql;
+    QString hostName = QStringLiteral("127.0.0.1");
+    int port = 3306;
+    QString databaseName = QStringLiteral("rainhub_db"); // SQLite 后端时为数据库文件路径或 ":memory:"
+    QString userName = QStringLiteral("root");
+    QString password = QStringLiteral("root");
+    int minConnections = 2;          // 启动时预建的连接数
+    int maxConnections = 8;          // 连接数上限
+    int acquireTimeoutMs = 3000;     // 等待空闲连接的默认超时
+    int validateAfterIdleMs = 30000; // 空闲超过该时长的连接在借出前做一次健康检查
+    int idleTimeoutMs = 300000;      // 超出 minConnections 的连接空闲超过该时长后关闭回收，<= 0 时不回收
+    int connectTimeoutSec = 3;       // MySQL 握手超时，数据库宕机时单次连接最多阻塞这么久
+    int failureThreshold = 2;        // 连续连接失败多少次后熔断
+    int reconnectBackoffMs = 1000;   // 熔断后第一次重连前的冷却时间，之后每失败一次翻倍
+    int maxReconnectBackoffMs = 30000; // 冷却时间上限
+    int pingIntervalMs = 10000;      // 后台存活探测间隔（DbHealthMonitor 使用）
+    QString replicaHostName;         // 只读副本地址，为空时不做读写分离（仅 MySQL 后端）
+    int replicaPort = 3306;
+    int maxReplicaLagSec = 5;        // 副本复制延迟超过该值时只读请求回退到主库
+    int replicaLagCheckMs = 2000;    // 复制延迟的检查间隔
+    int replicaAcquireWaitMs = 50;   // 副本连接全部借出时最多等待这么久，之后回退主库
+};
+
+// 连接用途：只读请求可以路由到只读副本
+enum class DbAccess {
+    ReadWrite, // 主库
+    ReadOnly   // 只读副本优先，不满足条件时回退主库
+};
+
+// 数据库可用状态
+enum class DbHealth {
+    Healthy,  // 正常
+    Degraded, // 出现连接失败但尚未熔断
+    Down      // 已熔断，请求直接失败，等待后台重连
+};
+
+// 连接池运行状态，用于监控
+struct PoolStats {
+    int totalConnections = 0; // 当前存活的连接数
+    int idleConnections = 0;  // 空闲连接数
+    int inUseConnections = 0; // 已借出的连接数
+    int waitingThreads = 0;   // 等待队列长度
+    quint64 acquireTimeouts = 0; // 累计等待超时次数
+    quint64 rejectedRequests = 0; // 熔断期间被直接拒绝的请求数
+    quint64 connectionsOpened = 0;    // 累计新建的连接数
+    quint64 connectionsReclaimed = 0; // 累计因空闲超时回收的连接数
+    DbHealth health = DbHealth::Healthy;
+    quint64 replicaReads = 0;     // 由副本处理的只读请求数
+    quint64 replicaFallbacks = 0; // 因副本不可用或延迟过大回退到主库的只读请求数
+};
+
+class ConnectionPool;
+
+// 池中的一个物理连接
+struct PooledConnection {
+    ConnectionPool* owner = nullptr; // 所属连接池（主库或副本）
+    QSqlDatabase db;
+    QString name;          // 在 QSqlDatabase 注册表中的名字，只在创建时生成一次
+    qint64 lastReleasedMs = 0; // 最近一次归还或探测确认可用的时间（单调时钟），决定借出前是否要 ping
+    qint64 lastUsedMs = 0;     // 最近一次借出后归还的时间（单调时钟），后台探测不更新，决定空闲回收
+    int epoch = 0;             // 最近一次确认可用时的连接池纪元，落后于连接池时借出前必须先 ping
+};
+
+// 连接租约：持有期间独占一个连接，析构时自动归还给连接池
+class ConnectionLease {
+public:
+    ConnectionLease() = default;
+    ~ConnectionLease();
+    ConnectionLease(ConnectionLease&& other) noexcept;
+    ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+    bool isValid() const { return conn != nullptr; }
+    explicit operator bool() const { return isValid(); }
+    QSqlDatabase& database() { return conn->db; }
+    QSqlDatabase& operator*() { return conn->db; }
+    QSqlDatabase* operator->() { return &conn->db; }
+
+    void release(); // 提前归还连接
+
+private:
+    friend class ConnectionPool;
+    explicit ConnectionLease(PooledConnection* conn) : conn(conn) {}
+    PooledConnection* conn = nullptr;
+};
 
 class ConnectionPool{
     public:
-        static QSqlDatabase getThreadLocalConnection(); // 获取线程本地连接
-        static void removeThreadConnection();  // 移除线程本地连接
-};
\ No newline at end of file
+        static void configure(const PoolConfig& config); // 设置连接参数和池大小，第一次使用前调用
+        static ConnectionLease acquire(int timeoutMs = -1); // 借出一个主库连接，timeoutMs<0 时使用配置的默认超时
+        static ConnectionLease acquire(DbAccess access, int timeoutMs = -1); // 按用途借出连接
+        static PoolStats stats(); // 获取主库连接池状态
+        static PoolStats replicaStats(); // 获取副本连接池状态（未配置副本时为空）
+        static int capacity(); // 连接数上限
+        static PoolConfig config(); // 当前生效的配置
+        static PoolConfig configured(); // configure() 设置的配置，不会创建连接池，GUI 线程上读配置用这个
+        static DbHealth health(); // 当前数据库可用状态
+        // 存活探测：ping 最久未用的空闲连接（顺带保活），熔断冷却结束时尝试重连，返回探测后的状态
+        static DbHealth ping();
+        // 关闭空闲超过 idleTimeoutMs 的多余连接（主库和副本），返回回收的数量；ping() 会顺带调用
+        static int reclaimIdle();
+        // 状态变化回调，在触发变化的线程上调用（可能是 DB 工作线程）
+        static void setHealthListener(std::function<void(DbHealth)> listener);
+
+        ConnectionPool(const ConnectionPool&) = delete;
+        ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    private:
+        // 等待队列中的一个等待者，归还的连接直接移交给队首等待者
+        struct Waiter {
+            QWaitCondition cond;
+            PooledConnection* handed = nullptr;
+        };
+
+        ConnectionPool() = default;
+        static ConnectionPool& instance(); // 主库连接池
+        static ConnectionPool* replicaInstance(); // 副本连接池，未配置时为 nullptr
+        static PoolConfig& pendingConfig();
+        static ConnectionPool* create(const PoolConfig& config, bool replica);
+        PoolStats statsImpl();
+
+        void warmUp();
+        ConnectionLease acquireImpl(int timeoutMs);
+        void releaseImpl(PooledConnection* conn);
+        void returnPinged(PooledConnection* conn); // 探测完的连接放回空闲列表原来的位置，不算一次使用
+        PooledConnection* createConnection(); // 在锁外调用
+        bool openConnection(PooledConnection* conn);
+        bool validate(PooledConnection* conn, bool force = false);
+        DbHealth pingImpl();
+        int reclaimIdleImpl();
+        void recordConnectResult(bool ok); // 熔断器计数，在锁外调用
+        bool replicaLagAcceptable(QSqlDatabase& db);
+
+        friend class ConnectionLease;
+
+        PoolConfig settings;
+        bool isReplica = false;
+        QString namePrefix;                // 连接名前缀，区分主库和副本连接
+        mutable QMutex mutex;
+        std::vector<std::unique_ptr<PooledConnection>> connections; // 所有连接（拥有所有权）
+        QVector<PooledConnection*> idle;   // 空闲连接，按 lastUsedMs 从旧到新排列，后进先出以复用热连接
+        std::deque<Waiter*> waiters;       // 等待队列，先进先出
+        int pendingCreates = 0;            // 正在创建中的连接数（已占用名额）
+        int nextConnectionId = 0;
+        quint64 acquireTimeouts = 0;
+        quint64 connectionsOpened = 0;
+        quint64 connectionsReclaimed = 0;
+
+        // 熔断器状态（受 mutex 保护）
+        DbHealth healthState = DbHealth::Healthy;
+        bool circuitOpen = false;
+        bool probing = false;          // 冷却结束后是否已有调用方在做重连探测
+        int consecutiveFailures = 0;
+        int backoffMs = 0;
+        qint64 nextProbeMs = 0;        // 冷却结束时间（单调时钟）
+        quint64 rejectedRequests = 0;
+        std::function<void(DbHealth)> healthListener;
+        QAtomicInt epoch = 0;          // 熔断或发现断线时递增，使现有连接在下次借出前都先 ping 一次
+
+        // 副本复制延迟检查结果（只在副本池上使用）
+        QAtomicInteger<qint64> lagCheckDueMs = 0;
+        QAtomicInt lagOk = 1;
+};
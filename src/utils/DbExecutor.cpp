@@ -0,0 +1,20 @@
+#include "DbExecutor.h"
+#include "ConnectionPool.h"
+
+#include <QThreadPool>
+
+QThreadPool* DbExecutor::pool(){
+    static QThreadPool* workers = [](){
+        auto* p = new QThreadPool();
+        p->setObjectName(QStringLiteral("RainHub_DbWorkers"));
+        // 只读配置，不在这里创建连接池：第一次投递任务通常发生在 GUI 线程
+        p->setMaxThreadCount(qBound(1, ConnectionPool::configured().maxConnections, 4));
+        p->setExpiryTimeout(-1); // 工作线程常驻，避免反复创建线程
+        return p;
+    }();
+    return workers;
+}
+
+void DbExecutor::waitForDone(){
+    pool()->waitForDone();
+}
@@ -0,0 +1,59 @@
+/*
+  数据库异步执行器。
+  Service 的异步接口把阻塞的数据库调用投递到专用的 DB 工作线程池中执行，GUI 线程不再等待网络 I/O；
+  执行结果通过队列连接（Qt::QueuedConnection）投递给常驻的 QCoreApplication 对象，回到主线程（GUI 线程）再调用回调，
+  context 须是主线程上的对象（页面、窗口）。QPointer 不能跨线程使用，工作线程只看取消令牌，
+  context 是否已销毁在回到主线程后才检查，已销毁或令牌已取消时结果直接丢弃。
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+#include <QMetaObject>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// 取消令牌：页面发起新一轮刷新时取消上一轮还没回来的请求，避免旧数据覆盖新数据
+class CancelToken {
+public:
+    CancelToken() : flag(std::make_shared<std::atomic_bool>(false)) {}
+    void cancel() const { flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return flag->load(std::memory_order_relaxed); }
+private:
+    std::shared_ptr<std::atomic_bool> flag;
+};
+
+class DbExecutor {
+public:
+    // DB 工作线程池，线程数不超过连接池上限，保证每个工作线程都能拿到自己的连接
+    static QThreadPool* pool();
+    // 等待所有已投递的任务执行完毕，持有 Service 的窗口析构前调用
+    static void waitForDone();
+
+    // 在工作线程执行 job，结果通过队列调用回到主线程，context 仍存在时调用 onDone
+    template<typename Job, typename Callback>
+    static void submit(QObject* context, Job job, Callback onDone, CancelToken token = CancelToken()) {
+        using Result = std::invoke_result_t<Job&>;
+        Q_ASSERT(context && QCoreApplication::instance() && context->thread() == QCoreApplication::instance()->thread());
+        QPointer<QObject> guard(context); // 只在主线程上读取
+        pool()->start([guard, job = std::move(job), onDone = std::move(onDone), token]() mutable {
+            if (token.isCancelled()) return;
+            // 用 shared_ptr 装结果，std::unique_ptr 这类只能移动的结果也能放进可复制的回调里
+            auto result = std::make_shared<Result>(job());
+            if (token.isCancelled()) return;
+            // 投递给与连接池同样常驻的应用对象，不碰可能正在主线程上析构的 context
+            QCoreApplication* app = QCoreApplication::instance();
+            if (!app) return;
+            QMetaObject::invokeMethod(app, [guard, onDone, token, result]() {
+                if (!guard || token.isCancelled()) return;
+                onDone(std::move(*result));
+            }, Qt::QueuedConnection);
+        });
+    }
+};
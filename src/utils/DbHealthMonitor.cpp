@@ -0,0 +1,50 @@
+#include "DbHealthMonitor.h"
+#include "DbExecutor.h"
+
+#include <QTimer>
+#include <QMetaObject>
+#include <mutex>
+
+// 与连接池一样常驻进程，不随窗口销毁
+DbHealthMonitor* DbHealthMonitor::instance(){
+    static DbHealthMonitor* monitor = new DbHealthMonitor();
+    return monitor;
+}
+
+// 构造和定时器都在 GUI 线程，这里不碰连接池实例：第一次使用会预建连接，数据库宕机时会卡在连接超时上
+DbHealthMonitor::DbHealthMonitor(){
+    m_timer = new QTimer(this);
+    m_timer->setInterval(ConnectionPool::configured().pingIntervalMs);
+    connect(m_timer, &QTimer::timeout, this, &DbHealthMonitor::probe);
+}
+
+void DbHealthMonitor::start(){
+    if(m_timer->isActive()) return;
+    m_timer->start();
+    probe(); // 立即探测一次，连接池在工作线程上创建
+}
+
+void DbHealthMonitor::probe(){
+    if(m_probing) return;
+    m_probing = true;
+    DbExecutor::submit(this, [this](){
+        // 第一次探测时注册状态回调（会创建连接池），之后的变化由回调推送
+        static std::once_flag listenerInstalled;
+        std::call_once(listenerInstalled, [this](){
+            // 连接池的回调可能来自任意线程，统一转到本对象所在线程再更新状态
+            ConnectionPool::setHealthListener([this](DbHealth state){
+                QMetaObject::invokeMethod(this, [this, state](){ setState(state); }, Qt::QueuedConnection);
+            });
+        });
+        return ConnectionPool::ping();
+    }, [this](DbHealth state){
+        m_probing = false;
+        setState(state);
+    });
+}
+
+void DbHealthMonitor::setState(DbHealth state){
+    if(m_state == state) return;
+    m_state = state;
+    emit stateChanged(state);
+}
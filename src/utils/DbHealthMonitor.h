@@ -0,0 +1,33 @@
+/*
+  数据库健康监视器。
+  在 GUI 线程中按 PoolConfig::pingIntervalMs 定时把存活探测投递到 DB 工作线程执行（ConnectionPool::ping()），
+  顺带让空闲连接保活、在熔断冷却结束后后台重连；连接池状态变化时发出 stateChanged 信号，
+  客户端和管理端主窗口据此切换到降级模式，而不是让每次点击都卡在连接超时上。
+ */
+
+#pragma once
+
+#include <QObject>
+#include "ConnectionPool.h"
+
+class QTimer;
+
+class DbHealthMonitor : public QObject {
+    Q_OBJECT
+public:
+    static DbHealthMonitor* instance(); // 首次调用须在 GUI 线程
+    DbHealth state() const { return m_state; } // 第一次探测返回前为 Healthy
+    void start(); // 开始定时探测并立即探测一次，重复调用无副作用
+
+signals:
+    void stateChanged(DbHealth state);
+
+private:
+    DbHealthMonitor();
+    void probe();
+    void setState(DbHealth state);
+
+    QTimer *m_timer { nullptr };
+    DbHealth m_state { DbHealth::Healthy };
+    bool m_probing { false }; // 上一次探测还没回来时跳过本次
+};
@@ -0,0 +1,185 @@
+#include "QueryMetrics.h"
+
+#include <QHash>
+#include <QByteArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QDateTime>
+#include <QTimer>
+#include <QPointer>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <atomic>
+#include <algorithm>
+#include <array>
+
+namespace {
+// 直方图分桶：0~7us 每微秒一个桶，之后每个 2 的幂区间再等分 8 个子桶，上限约 2^40us
+constexpr int kSubBuckets = 8;
+constexpr int kMaxExponent = 40;
+constexpr int kBucketCount = kSubBuckets + (kMaxExponent - 2) * kSubBuckets;
+
+int bucketIndex(qint64 us){
+    if(us < kSubBuckets) return static_cast<int>(qMax<qint64>(0, us));
+    int exponent = 63 - qCountLeadingZeroBits(static_cast<quint64>(us)); // floor(log2(us)) >= 3
+    if(exponent >= kMaxExponent) return kBucketCount - 1;
+    int sub = static_cast<int>((us >> (exponent - 3)) & (kSubBuckets - 1));
+    return kSubBuckets + (exponent - 3) * kSubBuckets + sub;
+}
+
+// 桶内最大值，估算分位数时取上界，保证不会低估
+qint64 bucketUpperBound(int index){
+    if(index < kSubBuckets) return index;
+    int exponent = (index - kSubBuckets) / kSubBuckets + 3;
+    int sub = (index - kSubBuckets) % kSubBuckets;
+    qint64 width = qint64(1) << (exponent - 3);
+    return (kSubBuckets + sub) * width + width - 1;
+}
+
+struct MethodHistogram {
+    quint64 calls = 0;
+    quint64 errors = 0;
+    quint64 rows = 0;
+    qint64 totalUs = 0;
+    qint64 maxUs = 0;
+    std::array<quint64, kBucketCount> buckets {};
+
+    qint64 percentile(double p) const {
+        if(calls == 0) return 0;
+        quint64 target = static_cast<quint64>(p * calls + 0.5);
+        target = qBound<quint64>(1, target, calls);
+        quint64 seen = 0;
+        for(int i = 0; i < kBucketCount; ++i){
+            seen += buckets[i];
+            if(seen >= target) return qMin(bucketUpperBound(i), maxUs);
+        }
+        return maxUs;
+    }
+};
+
+// 与一次数据库往返相比，一次加锁的开销可以忽略，所以直接用一把锁保护全部统计
+struct Registry {
+    QMutex mutex;
+    QHash<QByteArray, MethodHistogram> methods;
+};
+
+Registry& registry(){
+    static Registry r;
+    return r;
+}
+
+std::atomic_bool enabledFlag { false };
+thread_local const QueryMetrics::Scope* currentScope = nullptr;
+
+QPointer<QTimer> dumpTimer;
+}
+
+QueryMetrics::Scope::Scope(const char* name) : name(name), parent(currentScope){
+    currentScope = this;
+}
+
+QueryMetrics::Scope::~Scope(){
+    currentScope = parent;
+}
+
+void QueryMetrics::setEnabled(bool enabled){
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+bool QueryMetrics::isEnabled(){
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+const char* QueryMetrics::currentMethod(){
+    return currentScope ? currentScope->name : "(unscoped)";
+}
+
+QString QueryMetrics::callChain(){
+    QStringList names;
+    for(const Scope* scope = currentScope; scope; scope = scope->parent){
+        names.prepend(QString::fromLatin1(scope->name));
+    }
+    return names.isEmpty() ? QStringLiteral("(unscoped)") : names.join(QStringLiteral(" > "));
+}
+
+void QueryMetrics::record(const char* method, qint64 elapsedUs, qint64 rows, bool ok){
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    MethodHistogram& h = r.methods[QByteArray(method)];
+    ++h.calls;
+    if(!ok) ++h.errors;
+    if(rows > 0) h.rows += static_cast<quint64>(rows);
+    h.totalUs += elapsedUs;
+    h.maxUs = qMax(h.maxUs, elapsedUs);
+    ++h.buckets[bucketIndex(elapsedUs)];
+}
+
+QVector<QueryMethodStats> QueryMetrics::snapshot(){
+    QVector<QueryMethodStats> result;
+    {
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        result.reserve(r.methods.size());
+        for(auto it = r.methods.cbegin(); it != r.methods.cend(); ++it){
+            const MethodHistogram& h = it.value();
+            QueryMethodStats s;
+            s.method = QString::fromLatin1(it.key());
+            s.calls = h.calls;
+            s.errors = h.errors;
+            s.rows = h.rows;
+            s.totalUs = h.totalUs;
+            s.p50Us = h.percentile(0.50);
+            s.p95Us = h.percentile(0.95);
+            s.p99Us = h.percentile(0.99);
+            s.maxUs = h.maxUs;
+            result.append(s);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const QueryMethodStats& a, const QueryMethodStats& b){
+        return a.totalUs > b.totalUs;
+    });
+    return result;
+}
+
+QString QueryMetrics::report(){
+    QString text;
+    QTextStream out(&text);
+    out << "# RainHub DAO query metrics " << QDateTime::currentDateTime().toString(Qt::ISODate) << "\n";
+    out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(QStringLiteral("method"), -40).arg(QStringLiteral("calls"), 8).arg(QStringLiteral("errors"), 7)
+               .arg(QStringLiteral("rows"), 10).arg(QStringLiteral("total_ms"), 10).arg(QStringLiteral("p50_us"), 9)
+               .arg(QStringLiteral("p95_us"), 9).arg(QStringLiteral("p99_us"), 9).arg(QStringLiteral("max_us"), 9);
+    for(const QueryMethodStats& s : snapshot()){
+        out << QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                   .arg(s.method, -40).arg(s.calls, 8).arg(s.errors, 7).arg(s.rows, 10)
+                   .arg(s.totalUs / 1000.0, 10, 'f', 1)
+                   .arg(s.p50Us, 9).arg(s.p95Us, 9).arg(s.p99Us, 9).arg(s.maxUs, 9);
+    }
+    return text;
+}
+
+void QueryMetrics::reset(){
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    r.methods.clear();
+}
+
+bool QueryMetrics::dumpToFile(const QString& path){
+    QSaveFile file(path); // 先写临时文件再替换，读取方不会看到写了一半的报告
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+        qWarning() << "[QueryMetrics] 无法写入统计文件:" << path << file.errorString();
+        return false;
+    }
+    file.write(report().toUtf8());
+    return file.commit();
+}
+
+void QueryMetrics::startPeriodicDump(const QString& path, int intervalMs){
+    if(dumpTimer) dumpTimer->deleteLater();
+    dumpTimer = new QTimer();
+    QObject::connect(dumpTimer.data(), &QTimer::timeout, [path](){ dumpToFile(path); });
+    dumpTimer->start(qMax(1000, intervalMs));
+}
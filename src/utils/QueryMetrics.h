@@ -0,0 +1,58 @@
+/*
+  DAO 查询耗时统计。
+  每个 DAO 方法（以及调用 DAO 的 Service 方法）开头声明一个 QueryMetrics::Scope 标明方法名，经 StatementCache::exec() 执行的语句
+  按方法名累计执行次数、失败次数、返回/影响行数和耗时直方图（对数分桶 + 线性子桶，相对误差不超过 1/8），
+  由直方图估算 p50/p95/p99，最大值精确记录。
+  默认关闭：关闭时 exec() 只多读一次原子标志，Scope 只多写一次线程局部指针。
+  统计结果可以通过 snapshot()/report() 在代码中读取，也可以定时写到文件里。
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// 单个 DAO 方法的统计
+struct QueryMethodStats {
+    QString method;      // 如 "GearDao::selectByStation"
+    quint64 calls = 0;   // 执行的语句数
+    quint64 errors = 0;  // 执行失败的语句数
+    quint64 rows = 0;    // 返回（SELECT）或影响（写操作）的行数合计，驱动无法给出行数时不计入
+    qint64 totalUs = 0;  // 总耗时（微秒）
+    qint64 p50Us = 0;
+    qint64 p95Us = 0;
+    qint64 p99Us = 0;
+    qint64 maxUs = 0;
+};
+
+class QueryMetrics {
+public:
+    // 标记当前线程正在执行的方法，嵌套的 Scope 组成调用链，析构时恢复外层；name 须为字符串字面量
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        friend class QueryMetrics;
+        const char* name;
+        const Scope* parent;
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    static const char* currentMethod(); // 当前线程最内层的方法，不在任何 Scope 内时为 "(unscoped)"
+    static QString callChain();         // 当前线程由外到内的调用链，如 "BorrowService::borrowGear > GearDao::selectByStationAndSlot"
+
+    // 记录一条语句的执行结果，由 StatementCache::exec() 调用；rows < 0 表示行数未知
+    static void record(const char* method, qint64 elapsedUs, qint64 rows, bool ok);
+
+    static QVector<QueryMethodStats> snapshot(); // 按总耗时降序
+    static QString report();                     // 文本表格
+    static void reset();
+
+    static bool dumpToFile(const QString& path); // 覆盖写入当前报告
+    // 在调用线程（需有事件循环，通常是 GUI 线程）上每隔 intervalMs 写一次报告，重复调用会替换之前的设置
+    static void startPeriodicDump(const QString& path, int intervalMs = 60000);
+};
@@ -0,0 +1,373 @@
+#include "SchemaMigrator.h"
+#include "ConnectionPool.h"
+#include "SqlDialect.h"
+
+#include <QDateTime>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QDebug>
+#include <iterator>
+
+namespace {
+
+bool isSqlite(){
+    return SqlDialect::backend() == DbBackend::Sqlite;
+}
+
+bool execSql(QSqlDatabase& db, const QString& sql, QString* error){
+    QSqlQuery query(db);
+    if(query.exec(sql)) return true;
+    *error = sql + QStringLiteral(": ") + query.lastError().text();
+    return false;
+}
+
+// 查询结果第一行第一列的计数，失败时返回 -1
+int countOf(QSqlDatabase& db, const QString& sql, const QVariantList& binds, QString* error){
+    QSqlQuery query(db);
+    query.prepare(sql);
+    for(const QVariant& value : binds) query.addBindValue(value);
+    if(!query.exec() || !query.next()){
+        *error = sql + QStringLiteral(": ") + query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+int indexExists(QSqlDatabase& db, const char* table, const char* index, QString* error){
+    if(isSqlite()){
+        return countOf(db, QStringLiteral("SELECT count(*) FROM sqlite_master WHERE type = 'index' AND tbl_name = ? AND name = ?"),
+                       { QLatin1String(table), QLatin1String(index) }, error);
+    }
+    return countOf(db, QStringLiteral("SELECT count(*) FROM information_schema.statistics "
+                                      "WHERE table_schema = DATABASE() AND table_name = ? AND index_name = ?"),
+                   { QLatin1String(table), QLatin1String(index) }, error);
+}
+
+int columnExists(QSqlDatabase& db, const char* table, const char* column, QString* error){
+    if(isSqlite()){
+        return countOf(db, QStringLiteral("SELECT count(*) FROM pragma_table_info(?) WHERE name = ?"),
+                       { QLatin1String(table), QLatin1String(column) }, error);
+    }
+    return countOf(db, QStringLiteral("SELECT count(*) FROM information_schema.columns "
+                                      "WHERE table_schema = DATABASE() AND table_name = ? AND column_name = ?"),
+                   { QLatin1String(table), QLatin1String(column) }, error);
+}
+
+// 索引不存在时创建，columns 如 "station_id, status"
+bool ensureIndex(QSqlDatabase& db, const char* table, const char* index, const char* columns, QString* error,
+                 bool unique = false){
+    int exists = indexExists(db, table, index, error);
+    if(exists < 0) return false;
+    if(exists > 0) return true;
+    const QString kind = unique ? QStringLiteral("UNIQUE INDEX") : QStringLiteral("INDEX");
+    if(isSqlite()){
+        return execSql(db, QStringLiteral("CREATE %1 %2 ON %3(%4)").arg(kind, QLatin1String(index), QLatin1String(table),
+                                                                       QLatin1String(columns)), error);
+    }
+    return execSql(db, QStringLiteral("ALTER TABLE %1 ADD %2 %3 (%4)").arg(QLatin1String(table), kind, QLatin1String(index),
+                                                                          QLatin1String(columns)), error);
+}
+
+// 索引存在时删除
+bool dropIndex(QSqlDatabase& db, const char* table, const char* index, QString* error){
+    int exists = indexExists(db, table, index, error);
+    if(exists < 0) return false;
+    if(exists == 0) return true;
+    if(isSqlite()){
+        return execSql(db, QStringLiteral("DROP INDEX %1").arg(QLatin1String(index)), error);
+    }
+    return execSql(db, QStringLiteral("ALTER TABLE %1 DROP INDEX %2").arg(QLatin1String(table), QLatin1String(index)), error);
+}
+
+// 列不存在时追加，definition 如 "int null"
+bool ensureColumn(QSqlDatabase& db, const char* table, const char* column, const char* definition, QString* error){
+    int exists = columnExists(db, table, column, error);
+    if(exists < 0) return false;
+    if(exists > 0) return true;
+    return execSql(db, QStringLiteral("ALTER TABLE %1 ADD COLUMN %2 %3").arg(QLatin1String(table), QLatin1String(column),
+                                                                            QLatin1String(definition)), error);
+}
+
+// 1: 合并原 sql/upgrade_*.sql 的历史升级，并补齐建表时的基础索引
+// 先建新索引再删被覆盖的旧索引，MySQL 外键列在任何时刻都有可用的索引
+bool migrateBaselineIndexes(QSqlDatabase& db, QString* error){
+    return ensureIndex(db, "users", "idx_role", "role", error)
+        && ensureIndex(db, "users", "idx_real_name", "real_name", error)
+        && ensureIndex(db, "raingear", "idx_station_status", "station_id, status", error)
+        && dropIndex(db, "raingear", "idx_station", error)
+        && ensureIndex(db, "raingear", "idx_status", "status", error)
+        && ensureColumn(db, "record", "station_id", "int null", error)
+        && ensureIndex(db, "record", "idx_user_time", "user_id, borrow_time", error)
+        && ensureIndex(db, "record", "idx_gear_time", "gear_id, borrow_time", error)
+        && ensureIndex(db, "record", "idx_station_time", "station_id, borrow_time", error)
+        && ensureIndex(db, "record", "idx_borrow_time", "borrow_time, record_id", error)
+        && ensureIndex(db, "record", "idx_return_time", "return_time, borrow_time", error)
+        && dropIndex(db, "record", "idx_user", error)
+        && dropIndex(db, "record", "idx_gear", error);
+}
+
+// 2: 槽位唯一约束，以及借伞、还伞热点查询的联合索引
+// 借出中的雨具原先槽位记为 0，同一站点会有多把 (station_id, 0)，先统一改为 NULL（唯一索引允许多个 NULL）；
+// 有 uk_station_slot 后 station_id AND slot_id [AND status] 的查询最多命中一行，不需要再单独建 (station_id, slot_id, status)
+bool migrateSlotAndOpenBorrowIndexes(QSqlDatabase& db, QString* error){
+    if(!execSql(db, QStringLiteral("UPDATE raingear SET slot_id = NULL WHERE slot_id = 0"), error)) return false;
+
+    QSqlQuery dup(db);
+    if(!dup.exec(QStringLiteral("SELECT station_id, slot_id, count(*) FROM raingear "
+                                "WHERE station_id IS NOT NULL AND slot_id IS NOT NULL "
+                                "GROUP BY station_id, slot_id HAVING count(*) > 1"))){
+        *error = dup.lastError().text();
+        return false;
+    }
+    QStringList duplicates;
+    while(dup.next()){
+        duplicates.append(QStringLiteral("站点%1槽位%2(%3把)").arg(dup.value(0).toInt()).arg(dup.value(1).toInt()).arg(dup.value(2).toInt()));
+    }
+    if(!duplicates.isEmpty()){
+        *error = QStringLiteral("以下槽位登记了多把雨具，请先在管理端修正后再迁移：") + duplicates.join(QStringLiteral("，"));
+        return false;
+    }
+
+    return ensureIndex(db, "raingear", "uk_station_slot", "station_id, slot_id", error, true)
+        && ensureIndex(db, "record", "idx_user_return", "user_id, return_time", error);
+}
+
+// 3: raingear、station 增加行版本号，写入时比较并递增，避免不同终端互相覆盖
+bool migrateRowVersions(QSqlDatabase& db, QString* error){
+    return ensureColumn(db, "raingear", "version", "int not null default 0", error)
+        && ensureColumn(db, "station", "version", "int not null default 0", error);
+}
+
+// 4: users 增加未归还订单指针，借还事务里维护；按现有未归还记录回填（历史上一人多单的取最新一单）
+bool migrateOpenRecordPointer(QSqlDatabase& db, QString* error){
+    return ensureColumn(db, "users", "open_record_id", "bigint null", error)
+        && execSql(db, QStringLiteral("UPDATE users SET open_record_id = "
+                                      "(SELECT max(r.record_id) FROM record r WHERE r.user_id = users.user_id AND r.return_time IS NULL) "
+                                      "WHERE open_record_id IS NULL"), error);
+}
+
+// 5: 借还请求去重表，终端重试同一请求时返回已记录的结果
+bool migrateRequestLog(QSqlDatabase& db, QString* error){
+    const QString sql = isSqlite()
+        ? QStringLiteral("CREATE TABLE IF NOT EXISTS request_log ("
+                         " request_id TEXT NOT NULL PRIMARY KEY,"
+                         " user_id TEXT NOT NULL,"
+                         " kind INTEGER NOT NULL,"
+                         " message TEXT NOT NULL,"
+                         " cost REAL NOT NULL DEFAULT 0.00,"
+                         " created_at TEXT NOT NULL)")
+        : QStringLiteral("CREATE TABLE IF NOT EXISTS request_log ("
+                         " request_id varchar(64) not null,"
+                         " user_id varchar(20) not null,"
+                         " kind int not null,"
+                         " message varchar(200) not null,"
+                         " cost decimal(10, 2) not null default 0.00,"
+                         " created_at datetime not null,"
+                         " primary key (request_id)"
+                         ") engine=innodb default charset=utf8mb4");
+    return execSql(db, sql, error)
+        && ensureIndex(db, "request_log", "idx_created_at", "created_at", error);
+}
+
+// 6: 给 open_record_id 加外键
+// 迁移 4 回填时一人多单只指向最新一单，更早的未归还订单既不能还也不会再被查到。
+// 这类订单涉及押金和雨具状态，迁移不替管理员结算：列出冲突的订单后中止，人工处理后再迁移。
+// 指向不存在或已归还订单的指针只是派生数据，会让用户永远借不了，记日志后清空并重新指向未归还订单。
+// MySQL 上再加外键；SQLite 不支持给已有表加外键，新建的库由建表语句带上，已有库只做检查和指针修正
+bool migrateOpenRecordForeignKey(QSqlDatabase& db, QString* error){
+    QSqlQuery extra(db);
+    if(!extra.exec(QStringLiteral("SELECT user_id, record_id FROM record WHERE return_time IS NULL AND user_id IN "
+                                  "(SELECT user_id FROM record WHERE return_time IS NULL GROUP BY user_id HAVING count(*) > 1) "
+                                  "ORDER BY user_id, record_id"))){
+        *error = extra.lastError().text();
+        return false;
+    }
+    QStringList conflicts;
+    QString currentUser;
+    QStringList recordIds;
+    auto flush = [&](){
+        if(!recordIds.isEmpty()){
+            conflicts.append(QStringLiteral("用户%1(订单%2)").arg(currentUser, recordIds.join(QStringLiteral("、"))));
+        }
+        recordIds.clear();
+    };
+    while(extra.next()){
+        const QString userId = extra.value(0).toString();
+        if(userId != currentUser){
+            flush();
+            currentUser = userId;
+        }
+        recordIds.append(extra.value(1).toString());
+    }
+    flush();
+    if(!conflicts.isEmpty()){
+        *error = QStringLiteral("以下用户有多条未归还订单，请先核对雨具和押金、在库中结清多余订单后再迁移：")
+               + conflicts.join(QStringLiteral("，"));
+        return false;
+    }
+
+    const QString stalePointer = QStringLiteral("open_record_id IS NOT NULL AND NOT EXISTS "
+                                                "(SELECT 1 FROM record r WHERE r.record_id = users.open_record_id AND r.return_time IS NULL)");
+    int stale = countOf(db, QStringLiteral("SELECT count(*) FROM users WHERE ") + stalePointer, {}, error);
+    if(stale < 0) return false;
+    if(stale > 0){
+        qWarning() << "[SchemaMigrator] 清空" << stale << "个指向不存在或已归还订单的 open_record_id";
+        if(!execSql(db, QStringLiteral("UPDATE users SET open_record_id = NULL WHERE ") + stalePointer, error)) return false;
+    }
+    // 清空后如果还有未归还订单，重新指向它
+    if(!execSql(db, QStringLiteral("UPDATE users SET open_record_id = "
+                                   "(SELECT max(r.record_id) FROM record r WHERE r.user_id = users.user_id AND r.return_time IS NULL) "
+                                   "WHERE open_record_id IS NULL"), error)){
+        return false;
+    }
+
+    if(isSqlite()) return true;
+    int exists = countOf(db, QStringLiteral("SELECT count(*) FROM information_schema.table_constraints "
+                                            "WHERE table_schema = DATABASE() AND table_name = 'users' "
+                                            "AND constraint_name = 'fk_users_open_record' AND constraint_type = 'FOREIGN KEY'"),
+                         {}, error);
+    if(exists < 0) return false;
+    if(exists > 0) return true;
+    return execSql(db, QStringLiteral("ALTER TABLE users ADD CONSTRAINT fk_users_open_record FOREIGN KEY (open_record_id) "
+                                      "REFERENCES record(record_id) ON DELETE SET NULL"), error);
+}
+
+struct Migration {
+    int version;
+    const char* description;
+    bool (*apply)(QSqlDatabase& db, QString* error);
+};
+
+// 按版本号递增排列，只能在末尾追加
+const Migration kMigrations[] = {
+    { 1, "基础索引与订单流水索引（合并原 upgrade_*.sql）", migrateBaselineIndexes },
+    { 2, "雨具槽位唯一约束与未归还订单索引", migrateSlotAndOpenBorrowIndexes },
+    { 3, "雨具、站点行版本号", migrateRowVersions },
+    { 4, "用户未归还订单指针", migrateOpenRecordPointer },
+    { 5, "借还请求去重表", migrateRequestLog },
+    { 6, "检查一人多单并给未归还订单指针加外键", migrateOpenRecordForeignKey },
+};
+
+bool ensureVersionTable(QSqlDatabase& db, QString* error){
+    if(isSqlite()){
+        return execSql(db, QStringLiteral("CREATE TABLE IF NOT EXISTS schema_version ("
+                                          " version INTEGER NOT NULL PRIMARY KEY,"
+                                          " description TEXT NOT NULL,"
+                                          " applied_at TEXT NOT NULL)"), error);
+    }
+    return execSql(db, QStringLiteral("CREATE TABLE IF NOT EXISTS schema_version ("
+                                      " version int not null,"
+                                      " description varchar(100) not null,"
+                                      " applied_at datetime not null,"
+                                      " primary key (version)"
+                                      ") engine=innodb default charset=utf8mb4"), error);
+}
+
+bool recordVersion(QSqlDatabase& db, const Migration& migration, QString* error){
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral("INSERT INTO schema_version (version, description, applied_at) VALUES (?, ?, %1)")
+                  .arg(SqlDialect::datetimeParam()));
+    query.addBindValue(migration.version);
+    query.addBindValue(QString::fromUtf8(migration.description));
+    query.addBindValue(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
+    if(query.exec()) return true;
+    *error = query.lastError().text();
+    return false;
+}
+
+// MySQL 命名锁：多个进程同时启动时排队迁移，后来者看到的已经是新版本
+class MigrationLock {
+public:
+    explicit MigrationLock(QSqlDatabase& db) : db(db) {
+        if(isSqlite()){
+            held = true;
+            return;
+        }
+        QSqlQuery query(db);
+        held = query.exec(QStringLiteral("SELECT GET_LOCK('rainhub_schema_migration', 30)")) && query.next()
+            && query.value(0).toInt() == 1;
+        acquired = held;
+    }
+    ~MigrationLock(){
+        if(!acquired) return;
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("SELECT RELEASE_LOCK('rainhub_schema_migration')"));
+    }
+    bool isHeld() const { return held; }
+private:
+    QSqlDatabase& db;
+    bool held = false;
+    bool acquired = false; // 需要释放的 MySQL 锁
+};
+
+} // namespace
+
+int SchemaMigrator::latestVersion(){
+    return kMigrations[std::size(kMigrations) - 1].version;
+}
+
+int SchemaMigrator::currentVersion(QSqlDatabase& db, bool* ok){
+    if(ok) *ok = false;
+    QString error;
+    if(!ensureVersionTable(db, &error)){
+        qWarning() << "[SchemaMigrator] Error:" << error;
+        return 0;
+    }
+    QSqlQuery query(db);
+    if(!query.exec(QStringLiteral("SELECT max(version) FROM schema_version")) || !query.next()){
+        qWarning() << "[SchemaMigrator] Error:" << query.lastError().text();
+        return 0;
+    }
+    if(ok) *ok = true;
+    return query.value(0).toInt(); // 空表时为 NULL，即 0
+}
+
+MigrationReport SchemaMigrator::migrate(QSqlDatabase& db){
+    MigrationReport report;
+    MigrationLock lock(db);
+    if(!lock.isHeld()){
+        report.error = QStringLiteral("等待迁移锁超时，可能有其他进程正在迁移");
+        return report;
+    }
+    bool ok = false;
+    report.fromVersion = report.toVersion = currentVersion(db, &ok);
+    if(!ok){
+        report.error = QStringLiteral("无法读取 schema_version");
+        return report;
+    }
+
+    for(const Migration& migration : kMigrations){
+        if(migration.version <= report.toVersion) continue;
+        // SQLite 的 DDL 可以回滚，整个迁移放在一个事务里；MySQL 的 DDL 会隐式提交，靠每一步的存在性检查保证可重入
+        const bool atomic = isSqlite() && db.transaction();
+        QString error;
+        bool done = migration.apply(db, &error) && recordVersion(db, migration, &error);
+        if(atomic){
+            if(done && !db.commit()){
+                error = db.lastError().text();
+                done = false;
+            }
+            if(!done) db.rollback();
+        }
+        if(!done){
+            report.error = QStringLiteral("迁移 %1 失败：%2").arg(migration.version).arg(error);
+            qCritical() << "[SchemaMigrator]" << report.error;
+            return report;
+        }
+        report.toVersion = migration.version;
+        report.applied.append(QStringLiteral("%1: %2").arg(migration.version).arg(QString::fromUtf8(migration.description)));
+        qInfo() << "[SchemaMigrator] 已执行迁移" << report.applied.last();
+    }
+    report.ok = true;
+    return report;
+}
+
+MigrationReport SchemaMigrator::migrate(){
+    auto lease = ConnectionPool::acquire();
+    if(!lease){
+        MigrationReport report;
+        report.error = QStringLiteral("数据库连接不可用");
+        return report;
+    }
+    return migrate(*lease);
+}
@@ -0,0 +1,31 @@
+/*
+  数据库结构版本迁移。
+  库里用 schema_version 表记录已经执行过的迁移版本，启动时（或管理端 --migrate 命令行）按版本号顺序执行尚未执行的迁移，
+  已部署的库不需要再手工跑升级脚本。每个迁移步骤执行前都先检查索引/列是否已存在，
+  重复执行（包括 MySQL 上 DDL 不能回滚、执行到一半中断后再次执行）不会报错。
+  MySQL 上用 GET_LOCK 保证同一时刻只有一个进程在迁移；SQLite 上每个迁移在一个事务里执行。
+  新的结构变更在 SchemaMigrator.cpp 的迁移列表末尾追加一项，版本号递增，不要修改已发布的迁移。
+ */
+
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+// 一次 migrate() 的结果
+struct MigrationReport {
+    bool ok = false;
+    int fromVersion = 0;   // 迁移前的版本
+    int toVersion = 0;     // 迁移后的版本（失败时为最后一个成功的版本）
+    QStringList applied;   // 本次执行的迁移，如 "2: 雨具槽位唯一约束……"
+    QString error;         // 失败原因
+};
+
+class SchemaMigrator {
+public:
+    static int latestVersion(); // 代码中最新的结构版本
+    static int currentVersion(QSqlDatabase& db, bool* ok = nullptr); // 库中已执行到的版本，没有版本表时为 0
+    static MigrationReport migrate(QSqlDatabase& db); // 在给定连接上执行所有未执行的迁移
+    static MigrationReport migrate(); // 从连接池借一个主库连接执行
+};
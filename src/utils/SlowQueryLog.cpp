@@ -0,0 +1,172 @@
+#include "SlowQueryLog.h"
+#include "ConnectionPool.h"
+#include "DbExecutor.h"
+#include "QueryMetrics.h"
+#include "SqlDialect.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QSqlRecord>
+#include <QSqlError>
+#include <QStringList>
+#include <QVariant>
+#include <QDebug>
+#include <atomic>
+
+namespace {
+struct State {
+    QMutex mutex;
+    SlowQueryConfig config;
+    QHash<QString, qint64> lastLoggedMs; // SQL 文本 -> 最近一次记录的时间
+    QHash<QString, int> suppressed;      // SQL 文本 -> 限流期间被抑制的次数
+    bool explainRunning = false;
+    QMutex fileMutex;
+};
+
+State& state(){
+    static State s;
+    return s;
+}
+
+std::atomic<qint64> thresholdUsValue { 0 };
+
+qint64 monotonicMs(){
+    static QElapsedTimer clock = [](){ QElapsedTimer t; t.start(); return t; }();
+    return clock.elapsed();
+}
+
+QString formatValue(const QVariant& value){
+    if(value.isNull()) return QStringLiteral("NULL");
+    QString text = value.toString();
+    if(text.size() > 64) text = text.left(61) + QStringLiteral("...");
+    if(value.userType() == QMetaType::QString) return QLatin1Char('\'') + text + QLatin1Char('\'');
+    return text;
+}
+
+bool isExplainable(const QString& sql){
+    static const QRegularExpression dml(QStringLiteral("^\\s*(SELECT|UPDATE|DELETE|INSERT)\\b"),
+                                        QRegularExpression::CaseInsensitiveOption);
+    return dml.match(sql).hasMatch();
+}
+
+// 在另一个连接上执行 EXPLAIN，使用与原语句相同的参数
+QString explainPlan(const QString& sql, const QVariantList& params){
+    auto lease = ConnectionPool::acquire(500);
+    if(!lease) return QStringLiteral("    (no free connection for EXPLAIN)");
+    QSqlQuery query(*lease);
+    if(!query.prepare(SqlDialect::explainPrefix() + sql)){
+        return QStringLiteral("    (EXPLAIN prepare failed: %1)").arg(query.lastError().text());
+    }
+    for(int i = 0; i < params.size(); ++i){
+        query.bindValue(i, params.at(i));
+    }
+    if(!query.exec()){
+        return QStringLiteral("    (EXPLAIN failed: %1)").arg(query.lastError().text());
+    }
+    QStringList lines;
+    while(query.next()){
+        QSqlRecord record = query.record();
+        QStringList columns;
+        for(int c = 0; c < record.count(); ++c){
+            columns << record.fieldName(c) + QLatin1Char('=') + query.value(c).toString();
+        }
+        lines << QStringLiteral("    ") + columns.join(QStringLiteral(", "));
+    }
+    return lines.isEmpty() ? QStringLiteral("    (empty plan)") : lines.join(QLatin1Char('\n'));
+}
+
+void writeEntry(const QString& logFile, const QString& entry){
+    qWarning().noquote() << entry;
+    if(logFile.isEmpty()) return;
+    State& s = state();
+    QMutexLocker locker(&s.fileMutex);
+    QFile file(logFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return;
+    QTextStream out(&file);
+    out << entry << "\n\n";
+}
+}
+
+void SlowQueryLog::configure(const SlowQueryConfig& config){
+    State& s = state();
+    QMutexLocker locker(&s.mutex);
+    s.config = config;
+    s.lastLoggedMs.clear();
+    s.suppressed.clear();
+    thresholdUsValue.store(config.thresholdMs > 0 ? qint64(config.thresholdMs) * 1000 : 0, std::memory_order_relaxed);
+}
+
+bool SlowQueryLog::isEnabled(){
+    return thresholdUsValue.load(std::memory_order_relaxed) > 0;
+}
+
+qint64 SlowQueryLog::thresholdUs(){
+    return thresholdUsValue.load(std::memory_order_relaxed);
+}
+
+void SlowQueryLog::report(const QSqlQuery& query, qint64 elapsedUs){
+    const QString sql = query.lastQuery();
+    State& s = state();
+    SlowQueryConfig config;
+    int suppressed = 0;
+    bool runExplain = false;
+    {
+        QMutexLocker locker(&s.mutex);
+        config = s.config;
+        qint64 now = monotonicMs();
+        auto it = s.lastLoggedMs.constFind(sql);
+        if(it != s.lastLoggedMs.constEnd() && now - it.value() < config.sameStatementIntervalMs){
+            ++s.suppressed[sql];
+            return;
+        }
+        s.lastLoggedMs.insert(sql, now);
+        suppressed = s.suppressed.take(sql);
+        if(config.explain && !s.explainRunning && isExplainable(sql)){
+            s.explainRunning = true;
+            runExplain = true;
+        }
+    }
+
+    // 参数和调用链只在当前线程上才拿得到，先收集好再交给工作线程
+    static const QRegularExpression passwordColumn(QStringLiteral("password\\s*="), QRegularExpression::CaseInsensitiveOption);
+    const bool redact = sql.contains(passwordColumn);
+    QVariantList params;
+    QStringList shownParams;
+    const int paramCount = static_cast<int>(query.boundValues().size());
+    for(int i = 0; i < paramCount; ++i){
+        QVariant value = query.boundValue(i);
+        params.append(value);
+        shownParams << (redact ? QStringLiteral("***") : formatValue(value));
+    }
+
+    QString entry;
+    QTextStream out(&entry);
+    out << "[SlowQuery] " << QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"))
+        << "  " << QString::number(elapsedUs / 1000.0, 'f', 1) << " ms"
+        << "  caller: " << QueryMetrics::callChain() << "\n"
+        << "  sql: " << sql << "\n"
+        << "  params: [" << shownParams.join(QStringLiteral(", ")) << "]";
+    if(suppressed > 0){
+        out << "\n  (" << suppressed << " more occurrences suppressed since last report)";
+    }
+    out.flush();
+
+    if(!runExplain){
+        writeEntry(config.logFile, entry);
+        return;
+    }
+    // EXPLAIN 放到 DB 工作线程上执行，不拖慢本来就已经很慢的当前请求
+    DbExecutor::pool()->start([entry, sql, params, logFile = config.logFile](){
+        QString plan = explainPlan(sql, params);
+        writeEntry(logFile, entry + QStringLiteral("\n  plan:\n") + plan);
+        State& s = state();
+        QMutexLocker locker(&s.mutex);
+        s.explainRunning = false;
+    });
+}
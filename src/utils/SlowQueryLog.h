@@ -0,0 +1,30 @@
+/*
+  慢查询日志。
+  经 StatementCache::exec() 执行、耗时超过阈值的语句会被记录：SQL 文本、绑定参数、调用链（Service > DAO 方法）和耗时，
+  并在 DB 工作线程上另借一个连接执行 EXPLAIN 拿到执行计划一并写入日志，不占用、不干扰原连接上的事务。
+  同一条 SQL 在 sameStatementIntervalMs 内只记录一次（期间被抑制的次数会在下一条日志里带上），
+  同一时刻最多只有一个 EXPLAIN 在执行，避免数据库本来就慢的时候再被日志放大压力。
+  涉及密码列的语句不记录参数值。
+ */
+
+#pragma once
+
+#include <QSqlQuery>
+#include <QString>
+
+struct SlowQueryConfig {
+    int thresholdMs = 0;                  // 慢查询阈值，<= 0 时关闭
+    bool explain = true;                  // 是否抓取执行计划
+    int sameStatementIntervalMs = 60000;  // 同一条 SQL 两次记录之间的最小间隔
+    QString logFile;                      // 追加写入的日志文件，为空时只输出到 qWarning
+};
+
+class SlowQueryLog {
+public:
+    static void configure(const SlowQueryConfig& config);
+    static bool isEnabled();
+    static qint64 thresholdUs(); // 阈值（微秒），关闭时为 0
+
+    // 由 StatementCache::exec() 在语句超过阈值时调用（在执行语句的线程上）
+    static void report(const QSqlQuery& query, qint64 elapsedUs);
+};
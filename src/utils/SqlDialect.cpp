@@ -0,0 +1,124 @@
+#include "SqlDialect.h"
+
+#include <QSqlError>
+#include <atomic>
+
+namespace {
+std::atomic<DbBackend> currentBackend { DbBackend::MySql };
+}
+
+DbBackend SqlDialect::backend(){
+    return currentBackend.load(std::memory_order_relaxed);
+}
+
+void SqlDialect::setBackend(DbBackend backend){
+    currentBackend.store(backend, std::memory_order_relaxed);
+}
+
+QString SqlDialect::driverName(DbBackend backend){
+    switch(backend){
+        case DbBackend::Sqlite: return QStringLiteral("QSQLITE");
+        case DbBackend::MySql:
+        default:                return QStringLiteral("QMYSQL");
+    }
+}
+
+// SQLite 没有 DATETIME 类型，时间直接按 'yyyy-MM-dd hh:mm:ss' 文本存储，字典序即时间序
+QString SqlDialect::datetimeParam(){
+    if(backend() == DbBackend::Sqlite) return QStringLiteral("?");
+    return QStringLiteral("STR_TO_DATE(?, '%Y-%m-%d %H:%i:%s')");
+}
+
+QStringList SqlDialect::sessionInitStatements(){
+    if(backend() == DbBackend::Sqlite){
+        return {
+            QStringLiteral("PRAGMA foreign_keys = ON"),
+            QStringLiteral("PRAGMA busy_timeout = 5000"), // 多个连接同时写时等待锁，而不是立即报 SQLITE_BUSY
+            QStringLiteral("PRAGMA journal_mode = WAL")   // 内存库会忽略该设置
+        };
+    }
+    return { QStringLiteral("SET time_zone = '+8:00'") };
+}
+
+// 与 sql/init_db.sql 保持一致的表结构；索引和后加的列由 SchemaMigrator 的迁移补齐，老库文件也能升级
+QStringList SqlDialect::schemaStatements(){
+    if(backend() != DbBackend::Sqlite) return {};
+    return {
+        QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS users ("
+            " user_id TEXT NOT NULL PRIMARY KEY,"
+            " password TEXT NULL,"
+            " real_name TEXT NOT NULL,"
+            " role INTEGER NOT NULL DEFAULT 0,"
+            " credit REAL NOT NULL DEFAULT 0.00,"
+            " is_active INTEGER NOT NULL DEFAULT 0,"
+            " open_record_id INTEGER NULL REFERENCES record(record_id) ON DELETE SET NULL)"),
+        QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS station ("
+            " station_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            " name TEXT NOT NULL,"
+            " pos_x REAL NOT NULL,"
+            " pos_y REAL NOT NULL,"
+            " status INTEGER NOT NULL DEFAULT 1,"
+            " unavailable_slots TEXT NOT NULL DEFAULT '',"
+            " version INTEGER NOT NULL DEFAULT 0)"),
+        QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS raingear ("
+            " gear_id TEXT NOT NULL PRIMARY KEY,"
+            " type_id INTEGER NOT NULL,"
+            " station_id INTEGER NULL REFERENCES station(station_id) ON DELETE SET NULL ON UPDATE CASCADE,"
+            " slot_id INTEGER NULL,"
+            " status INTEGER NOT NULL DEFAULT 1,"
+            " version INTEGER NOT NULL DEFAULT 0)"),
+        QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS record ("
+            " record_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            " user_id TEXT NOT NULL REFERENCES users(user_id) ON DELETE RESTRICT ON UPDATE CASCADE,"
+            " gear_id TEXT NOT NULL REFERENCES raingear(gear_id) ON DELETE RESTRICT ON UPDATE CASCADE,"
+            " station_id INTEGER NULL,"
+            " borrow_time TEXT NOT NULL,"
+            " return_time TEXT NULL,"
+            " cost REAL NOT NULL DEFAULT 0.00)"),
+        QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS request_log ("
+            " request_id TEXT NOT NULL PRIMARY KEY,"
+            " user_id TEXT NOT NULL,"
+            " kind INTEGER NOT NULL,"
+            " message TEXT NOT NULL,"
+            " cost REAL NOT NULL DEFAULT 0.00,"
+            " created_at TEXT NOT NULL)")
+    };
+}
+
+QString SqlDialect::explainPrefix(){
+    if(backend() == DbBackend::Sqlite) return QStringLiteral("EXPLAIN QUERY PLAN ");
+    return QStringLiteral("EXPLAIN ");
+}
+
+bool SqlDialect::isRetryableError(const QSqlError& error){
+    if(!error.isValid()) return false;
+    bool ok = false;
+    int code = error.nativeErrorCode().toInt(&ok);
+    if(!ok) return false;
+    if(backend() == DbBackend::Sqlite){
+        int primary = code & 0xff; // 扩展错误码的低 8 位是主错误码
+        return primary == 5 || primary == 6; // SQLITE_BUSY / SQLITE_LOCKED
+    }
+    return code == 1213 || code == 1205; // ER_LOCK_DEADLOCK / ER_LOCK_WAIT_TIMEOUT
+}
+
+bool SqlDialect::isConnectionLostError(const QSqlError& error){
+    if(!error.isValid() || backend() != DbBackend::MySql) return false;
+    int code = error.nativeErrorCode().toInt();
+    return code == 2006 || code == 2013; // CR_SERVER_GONE_ERROR / CR_SERVER_LOST
+}
+
+bool SqlDialect::isForeignKeyError(const QSqlError& error){
+    if(!error.isValid()) return false;
+    int code = error.nativeErrorCode().toInt();
+    if(backend() == DbBackend::Sqlite){
+        // 驱动不一定返回扩展错误码，只有主错误码 SQLITE_CONSTRAINT 时看错误信息
+        return code == 787 || (code == 19 && error.databaseText().contains(QLatin1String("FOREIGN KEY")));
+    }
+    return code == 1452 || code == 1216; // ER_NO_REFERENCED_ROW_2 / ER_NO_REFERENCED_ROW
+}
@@ -0,0 +1,40 @@
+/*
+  存储后端与 SQL 方言。
+  默认使用 MySQL（QMYSQL），单站离线部署或无 MySQL 环境下跑基准/测试时可以切换为内嵌 SQLite（QSQLITE，支持文件和 :memory:）。
+  两种后端绝大部分 SQL 是通用的，这里只收拢少数有差异的片段：时间参数转换、会话初始化语句和建表语句。
+  后端在连接池初始化时根据 PoolConfig 设置一次，整个进程只使用一种后端。
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+class QSqlError;
+
+enum class DbBackend {
+    MySql,  // QMYSQL，默认
+    Sqlite  // QSQLITE，内嵌
+};
+
+class SqlDialect {
+public:
+    static DbBackend backend(); // 当前进程使用的后端
+    static void setBackend(DbBackend backend); // 由连接池在初始化时调用
+    static QString driverName(DbBackend backend); // 对应的 Qt SQL 驱动名
+
+    // 把 'yyyy-MM-dd hh:mm:ss' 格式的字符串参数转换为时间的占位符表达式
+    static QString datetimeParam();
+    // 每个新连接打开后执行的会话初始化语句
+    static QStringList sessionInitStatements();
+    // 内嵌后端的建表语句，只建表不建索引（MySQL 仍由 sql/init_db.sql 初始化，返回空列表）
+    static QStringList schemaStatements();
+    // 查看执行计划的语句前缀
+    static QString explainPrefix();
+    // 是否为可重试的锁冲突错误：MySQL 死锁(1213)/锁等待超时(1205)，SQLite SQLITE_BUSY/SQLITE_LOCKED
+    static bool isRetryableError(const QSqlError& error);
+    // 是否为连接已断开的错误：MySQL server has gone away(2006)/Lost connection(2013)
+    static bool isConnectionLostError(const QSqlError& error);
+    // 是否为外键约束错误（引用的行不存在）：MySQL 1452/1216，SQLite SQLITE_CONSTRAINT_FOREIGNKEY
+    static bool isForeignKeyError(const QSqlError& error);
+};
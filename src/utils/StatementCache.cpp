@@ -0,0 +1,135 @@
+#include "StatementCache.h"
+#include "QueryMetrics.h"
+#include "SlowQueryLog.h"
+
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInteger>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+// 缓存项：语句对象由缓存和借出的句柄共同持有，引用计数大于 1 说明正被句柄占用
+struct Entry {
+    std::shared_ptr<QSqlQuery> query;
+};
+using Cache = QCache<QString, Entry>;
+
+// 每个连接同一时刻只会被一个租约持有，所以单个连接的 QCache 不需要加锁，只有注册表需要
+struct Registry {
+    QMutex mutex;
+    QHash<const QSqlDriver*, Cache*> caches; // 以驱动对象地址区分连接，避免按连接名做字符串查找
+    int capacity = 64;
+    QAtomicInteger<quint64> hits = 0;
+    QAtomicInteger<quint64> misses = 0;
+    QAtomicInteger<quint64> evictions = 0;
+    QAtomicInteger<int> cached = 0;
+};
+
+// 每个线程同一时刻最多持有一个连接，所以“最近一次错误”按线程记录即可
+thread_local QSqlError lastStatementError;
+
+Registry& registry(){
+    static Registry r;
+    return r;
+}
+
+Cache* cacheFor(const QSqlDatabase& db){
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    auto it = r.caches.find(db.driver());
+    if(it != r.caches.end()) return it.value();
+    auto* cache = new Cache(r.capacity);
+    r.caches.insert(db.driver(), cache);
+    return cache;
+}
+}
+
+CachedQuery StatementCache::prepare(QSqlDatabase& db, const QString& sql){
+    Registry& r = registry();
+    Cache* cache = cacheFor(db);
+
+    Entry* cached = cache->object(sql);
+    if(cached && cached->query.use_count() == 1){
+        r.hits.fetchAndAddRelaxed(1);
+        return CachedQuery(cached->query);
+    }
+
+    r.misses.fetchAndAddRelaxed(1);
+    auto query = std::make_shared<QSqlQuery>(db);
+    if(!query->prepare(sql)){
+        qWarning() << "[StatementCache] prepare 失败:" << query->lastError().text() << sql;
+        return CachedQuery(query); // 不缓存失败的语句，exec() 时调用方会拿到同样的错误
+    }
+    if(cached){
+        return CachedQuery(query); // 缓存里的同一条语句还在被外层调用使用，这一份用完即丢
+    }
+
+    if(cache->size() >= cache->maxCost()){
+        r.evictions.fetchAndAddRelaxed(1);
+    }else{
+        r.cached.fetchAndAddRelaxed(1);
+    }
+    cache->insert(sql, new Entry{query}); // QCache 接管缓存项，超出容量时淘汰最久未使用的语句
+    return CachedQuery(query);
+}
+
+bool StatementCache::exec(QSqlQuery& query){
+    bool ok;
+    const bool metrics = QueryMetrics::isEnabled();
+    const qint64 slowUs = SlowQueryLog::thresholdUs();
+    if(metrics || slowUs > 0){
+        QElapsedTimer timer;
+        timer.start();
+        ok = query.exec();
+        qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        if(metrics){
+            qint64 rows = query.isSelect() ? query.size() : query.numRowsAffected(); // SQLite 不支持 size()，返回 -1
+            QueryMetrics::record(QueryMetrics::currentMethod(), elapsedUs, ok ? rows : -1, ok);
+        }
+        if(slowUs > 0 && elapsedUs >= slowUs){
+            SlowQueryLog::report(query, elapsedUs);
+        }
+    }else{
+        ok = query.exec();
+    }
+    if(!ok) lastStatementError = query.lastError();
+    return ok;
+}
+
+QSqlError StatementCache::lastError(){
+    return lastStatementError;
+}
+
+void StatementCache::clearLastError(){
+    lastStatementError = QSqlError();
+}
+
+void StatementCache::invalidate(const QSqlDatabase& db){
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    Cache* cache = r.caches.take(db.driver());
+    if(!cache) return;
+    r.cached.fetchAndSubRelaxed(cache->size());
+    delete cache;
+}
+
+void StatementCache::setCapacity(int capacity){
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    r.capacity = qMax(1, capacity);
+}
+
+StatementCacheStats StatementCache::stats(){
+    Registry& r = registry();
+    StatementCacheStats s;
+    s.hits = r.hits.loadRelaxed();
+    s.misses = r.misses.loadRelaxed();
+    s.evictions = r.evictions.loadRelaxed();
+    s.cachedStatements = r.cached.loadRelaxed();
+    return s;
+}
@@ -0,0 +1,69 @@
+/*
+  预编译语句缓存。每个数据库连接各有一份，按 SQL 文本缓存已经 prepare 过的 QSqlQuery，
+  DAO 再次执行同一条 SQL 时只需重新绑定参数，省掉服务端的解析开销和一次网络往返。
+  缓存按 LRU 淘汰。缓存持有语句对象，调用方拿到的是不可复制的 CachedQuery 句柄，句柄析构时 finish() 释放结果集；
+  语句随后被淘汰时由句柄保持到用完为止。同一条语句还被句柄占用时（嵌套调用同一条 SQL），另建一个不入缓存的语句，
+  两个调用方不会互相覆盖绑定参数和游标。
+  DAO 统一通过 exec() 执行语句，失败时错误会记在当前线程上，事务重试（TransactionScope）据此判断是否为锁冲突。
+ */
+
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QString>
+#include <memory>
+
+// 语句缓存统计信息（所有连接汇总）
+struct StatementCacheStats {
+    quint64 hits = 0;      // 命中次数
+    quint64 misses = 0;    // 未命中（需要 prepare）次数
+    quint64 evictions = 0; // LRU 淘汰次数
+    int cachedStatements = 0; // 当前缓存的语句总数
+};
+
+// 预编译语句句柄：只能移动，析构时 finish() 释放结果集并保留预编译句柄，供下一次复用。
+// 用法：CachedQuery statement = StatementCache::prepare(db, sql); QSqlQuery& query = *statement;
+class CachedQuery {
+public:
+    CachedQuery() = default;
+    explicit CachedQuery(std::shared_ptr<QSqlQuery> query) : query(std::move(query)) {}
+    ~CachedQuery() { reset(); }
+    CachedQuery(CachedQuery&& other) noexcept = default;
+    CachedQuery& operator=(CachedQuery&& other) noexcept {
+        if (this != &other) {
+            reset();
+            query = std::move(other.query);
+        }
+        return *this;
+    }
+    CachedQuery(const CachedQuery&) = delete;
+    CachedQuery& operator=(const CachedQuery&) = delete;
+
+    QSqlQuery& operator*() const { return *query; }
+    QSqlQuery* operator->() const { return query.get(); }
+
+private:
+    void reset() {
+        if (query) query->finish();
+        query.reset();
+    }
+    std::shared_ptr<QSqlQuery> query;
+};
+
+class StatementCache {
+public:
+    // 取出（或新建）该连接上 sql 对应的预编译语句，调用方直接绑定参数后 exec()
+    static CachedQuery prepare(QSqlDatabase& db, const QString& sql);
+    // 执行语句，失败时把错误记为当前线程最近一次语句错误
+    static bool exec(QSqlQuery& query);
+    // 当前线程最近一次语句错误（没有失败过时为无效错误）
+    static QSqlError lastError();
+    static void clearLastError();
+    // 连接关闭或重连前调用，丢弃该连接上的全部预编译语句
+    static void invalidate(const QSqlDatabase& db);
+    // 每个连接最多缓存的语句数量，只对之后新建的连接缓存生效
+    static void setCapacity(int capacity);
+    static StatementCacheStats stats();
+};
@@ -0,0 +1,90 @@
+#include "TransactionScope.h"
+#include "SqlDialect.h"
+#include "StatementCache.h"
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QDebug>
+
+TransactionScope::TransactionScope(QSqlDatabase& db) : db(db) {
+    active = db.transaction();
+    if(!active) error = db.lastError();
+}
+
+TransactionScope::~TransactionScope(){
+    rollback();
+}
+
+bool TransactionScope::commit(){
+    if(!active) return false;
+    active = false;
+    if(db.commit()) return true;
+    error = db.lastError();
+    db.rollback(); // 提交失败时确保连接回到无事务状态再还给连接池
+    return false;
+}
+
+void TransactionScope::rollback(){
+    if(!active) return;
+    active = false;
+    db.rollback();
+}
+
+TransactionResult TransactionScope::run(QSqlDatabase& db, const std::function<bool(QSqlDatabase&)>& work,
+                                        const RetryPolicy& policy){
+    TransactionResult result;
+    QElapsedTimer total;
+    total.start();
+    const int maxAttempts = qMax(1, policy.maxAttempts);
+
+    for(int attempt = 1; attempt <= maxAttempts; ++attempt){
+        QElapsedTimer attemptTimer;
+        attemptTimer.start();
+        result.stats.attempts = attempt;
+        StatementCache::clearLastError();
+
+        QSqlError error;
+        {
+            TransactionScope scope(db);
+            if(!scope.isActive()){
+                error = scope.lastError();
+            }else if(!work(db)){
+                error = StatementCache::lastError(); // 业务校验失败时为无效错误，不会重试
+            }else if(scope.commit()){
+                result.committed = true;
+            }else{
+                error = scope.lastError();
+            }
+        } // 未提交的事务在这里回滚
+
+        if(result.committed) break;
+
+        result.error = error;
+        result.conflict = SqlDialect::isRetryableError(error);
+        if(!result.conflict) break;
+
+        result.stats.lockWaitMs += attemptTimer.elapsed();
+        if(attempt == maxAttempts) break;
+
+        // 指数退避 + 全随机抖动，避免冲突双方同时重试再次撞车
+        int ceiling = qMin(policy.maxBackoffMs, policy.baseBackoffMs << (attempt - 1));
+        int backoff = ceiling > 0 ? static_cast<int>(QRandomGenerator::global()->bounded(ceiling + 1)) : 0;
+        qInfo() << "[TransactionScope] 锁冲突，第" << attempt << "次执行失败:" << error.text()
+                << "，" << backoff << "ms 后重试";
+        QThread::msleep(static_cast<unsigned long>(backoff));
+        result.stats.lockWaitMs += backoff;
+    }
+
+    result.stats.elapsedMs = total.elapsed();
+    if(result.committed && result.stats.attempts > 1){
+        qInfo() << "[TransactionScope] 重试后提交成功，共执行" << result.stats.attempts << "次，耗时"
+                << result.stats.elapsedMs << "ms，其中锁等待" << result.stats.lockWaitMs << "ms";
+    }else if(result.conflict){
+        qWarning() << "[TransactionScope] 锁冲突重试次数用尽，共执行" << result.stats.attempts << "次，耗时"
+                   << result.stats.elapsedMs << "ms:" << result.error.text();
+    }else if(!result.committed && result.error.isValid()){
+        qCritical() << "[TransactionScope] 事务失败:" << result.error.text();
+    }
+    return result;
+}
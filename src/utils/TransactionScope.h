@@ -0,0 +1,60 @@
+/*
+  事务作用域。
+  构造时开启事务，析构时如果还没有提交就自动回滚，避免提前 return 时忘记 rollback 把半截事务带回连接池。
+  TransactionScope::run() 在事务中执行一段业务逻辑：逻辑返回 true 则提交，返回 false 则回滚；
+  遇到死锁、锁等待超时这类锁冲突时（开启、执行语句、提交任一环节）整体回滚后按带随机抖动的指数退避重新执行，
+  高峰期热门站点上的瞬时冲突在这里消化掉，不再作为“系统内部错误”直接反馈给用户。
+  因此传入的逻辑必须可以重复执行（只做数据库读写，不在里面修改外部状态）。
+ */
+
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <functional>
+
+// 重试策略
+struct RetryPolicy {
+    int maxAttempts = 3;    // 最多执行次数（含第一次）
+    int baseBackoffMs = 20; // 第 n 次重试前的退避上限为 baseBackoffMs * 2^(n-1)，实际等待在 [0, 上限] 内随机
+    int maxBackoffMs = 200; // 单次退避上限
+};
+
+// 单次 run() 的耗时统计
+struct TransactionStats {
+    int attempts = 0;       // 实际执行次数
+    qint64 elapsedMs = 0;   // 从第一次开启事务到最终提交/回滚的总耗时
+    qint64 lockWaitMs = 0;  // 因锁冲突损失的时间：失败尝试的耗时加上退避等待
+};
+
+// run() 的结果
+struct TransactionResult {
+    bool committed = false; // 是否已提交
+    bool conflict = false;  // 未提交且原因是锁冲突（重试次数用尽）
+    QSqlError error;        // 未提交时最后一次数据库错误；业务逻辑主动返回 false 时为无效错误
+    TransactionStats stats;
+
+    explicit operator bool() const { return committed; }
+};
+
+class TransactionScope {
+public:
+    explicit TransactionScope(QSqlDatabase& db);
+    ~TransactionScope(); // 未提交时回滚
+    TransactionScope(const TransactionScope&) = delete;
+    TransactionScope& operator=(const TransactionScope&) = delete;
+
+    bool isActive() const { return active; } // 事务是否开启且尚未结束
+    QSqlError lastError() const { return error; } // 开启或提交失败时的错误
+    bool commit();   // 提交，失败时事务同样结束（回滚）
+    void rollback();
+
+    // 在事务中执行 work，锁冲突时按 policy 重试
+    static TransactionResult run(QSqlDatabase& db, const std::function<bool(QSqlDatabase&)>& work,
+                                 const RetryPolicy& policy = RetryPolicy());
+
+private:
+    QSqlDatabase& db;
+    QSqlError error;
+    bool active = false;
+};
@@ -0,0 +1,348 @@
+/*
+  借还并发压力测试：多个终端线程在同一站点反复借伞、还伞，同时管理端线程按版本号修改雨具和站点状态。
+  结束后检查不变量：同一把雨具最多一条未归还订单、槽位占用与雨具行一致、余额与订单金额对得上（没有丢失更新），
+  以及每行的版本号等于成功写入的次数。使用 SQLite 临时库文件，不依赖 MySQL。
+  用法：BorrowStressTest [持续秒数，默认 5]
+ */
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QMutex>
+#include <QHash>
+#include <QUuid>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "../src/utils/ConnectionPool.h"
+#include "../src/utils/SchemaMigrator.h"
+#include "../src/control/BorrowService.h"
+#include "../src/control/Admin_GearService.h"
+#include "../src/control/Admin_StationService.h"
+#include "../src/Model/RainGearFactory.h"
+#include "../src/Model/StationUtils.h"
+
+namespace {
+constexpr Station kStation = Station::Wende;
+constexpr int kStationId = static_cast<int>(Station::Wende);
+constexpr int kSlotCount = 12;
+constexpr int kUserCount = 8;
+constexpr double kInitialCredit = 1000.0;
+// 每种类型留一个空槽位，还伞时总有地方可还：1-3、5-7、9、11 放雨具，4、8、10、12 空着
+const int kSeedSlots[] = { 1, 2, 3, 5, 6, 7, 9, 11 };
+
+int failures = 0;
+
+void check(bool condition, const char* what){
+    if(!condition){
+        qCritical() << "[FAIL]" << what;
+        ++failures;
+    }else{
+        qInfo() << "[ OK ]" << what;
+    }
+}
+
+// 槽位对应的雨具类型，与 StationUtils::isSlotForType 的划分一致
+GearType typeForSlot(int slotId){
+    for(GearType type : { GearType::StandardPlastic, GearType::PremiumWindproof, GearType::Sunshade, GearType::Raincoat }){
+        if(StationUtils::isSlotForType(type, slotId)) return type;
+    }
+    return GearType::Unknown;
+}
+
+QString userIdOf(int index){
+    return QStringLiteral("stress%1").arg(index, 2, 10, QLatin1Char('0'));
+}
+
+bool exec(QSqlDatabase& db, const QString& sql, const QVariantList& binds = {}){
+    QSqlQuery query(db);
+    query.prepare(sql);
+    for(const QVariant& value : binds) query.addBindValue(value);
+    if(query.exec()) return true;
+    qCritical() << sql << query.lastError().text();
+    return false;
+}
+
+// 查询结果第一行第一列，失败时返回 -1
+double scalar(QSqlDatabase& db, const QString& sql){
+    QSqlQuery query(db);
+    if(!query.exec(sql) || !query.next()){
+        qCritical() << sql << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toDouble();
+}
+
+bool seed(QSqlDatabase& db){
+    bool ok = exec(db, QStringLiteral("INSERT INTO station (station_id, name, pos_x, pos_y, status, unavailable_slots) "
+                                      "VALUES (?, '压测站点', 0, 0, 1, '')"), { kStationId });
+    for(int i = 0; i < kUserCount && ok; ++i){
+        ok = exec(db, QStringLiteral("INSERT INTO users (user_id, password, real_name, role, credit, is_active) "
+                                     "VALUES (?, NULL, ?, 0, ?, 1)"), { userIdOf(i), userIdOf(i), kInitialCredit });
+    }
+    for(int slotId : kSeedSlots){
+        if(!ok) break;
+        ok = exec(db, QStringLiteral("INSERT INTO raingear (gear_id, type_id, station_id, slot_id, status) VALUES (?, ?, ?, ?, 1)"),
+                  { QStringLiteral("G%1").arg(slotId, 2, 10, QLatin1Char('0')), static_cast<int>(typeForSlot(slotId)),
+                    kStationId, slotId });
+    }
+    return ok;
+}
+
+// 各线程共享的计数
+struct Counters {
+    std::atomic<int> borrowOk{0};
+    std::atomic<int> borrowFailed{0};
+    std::atomic<int> returnOk{0};
+    std::atomic<int> returnFailed{0};
+    std::atomic<int> gearEditOk{0};
+    std::atomic<int> gearEditConflict{0};
+    std::atomic<int> stationEditOk{0};
+    std::atomic<int> stationEditConflict{0};
+    std::atomic<int> writeErrors{0};
+    QMutex gearEditMutex;
+    QHash<QString, int> gearEditsById; // 管理端每把雨具成功修改的次数
+};
+
+// 终端线程：随机槽位借伞，借到后还到同类型的随机槽位，直到时间用完
+void runKiosk(const QString& userId, qint64 deadlineMs, const QElapsedTimer& clock, Counters* counters){
+    BorrowService service;
+    QRandomGenerator* random = QRandomGenerator::global();
+    while(clock.elapsed() < deadlineMs){
+        const int borrowSlot = 1 + random->bounded(kSlotCount);
+        ServiceResult borrowed = service.borrowGear(userId, kStation, borrowSlot, QUuid::createUuid().toString(QUuid::WithoutBraces));
+        if(!borrowed.success){
+            ++counters->borrowFailed;
+            continue;
+        }
+        ++counters->borrowOk;
+
+        QString gearId;
+        if(auto lease = ConnectionPool::acquire()){
+            RecordDao recordDao;
+            if(auto record = recordDao.selectUnfinishedByUserId(*lease, userId)) gearId = record->get_gear_id();
+        }
+        if(gearId.isEmpty()){
+            qCritical() << "借伞成功但查不到未归还订单" << userId;
+            ++counters->writeErrors;
+            continue;
+        }
+        const GearType type = typeForSlot(borrowSlot);
+        // 还伞会因为槽位被占、站点离线、锁冲突失败，换个槽位重试；时间到了就带着雨具退出，留给最后的检查
+        while(clock.elapsed() < deadlineMs){
+            int returnSlot = 1 + random->bounded(kSlotCount);
+            if(!StationUtils::isSlotForType(type, returnSlot)) continue;
+            ServiceResult returned = service.returnGear(userId, gearId, kStation, returnSlot,
+                                                        QUuid::createUuid().toString(QUuid::WithoutBraces));
+            if(returned.success){
+                ++counters->returnOk;
+                break;
+            }
+            ++counters->returnFailed;
+        }
+    }
+}
+
+// 管理端雨具线程：读一页雨具，按读到的版本号在可用和故障之间切换
+void runGearAdmin(qint64 deadlineMs, const QElapsedTimer& clock, Counters* counters){
+    Admin_GearService service;
+    QRandomGenerator* random = QRandomGenerator::global();
+    while(clock.elapsed() < deadlineMs){
+        GearPage page = service.getGearPage(kStationId, 0, QString(), PageDirection::After, 50);
+        if(page.gears.isEmpty()) continue;
+        const GearInfoDTO& gear = page.gears.at(random->bounded(static_cast<int>(page.gears.size())));
+        const int available = static_cast<int>(GearStatus::Available);
+        const int broken = static_cast<int>(GearStatus::Broken);
+        if(gear.status != available && gear.status != broken) continue; // 借出中的不动
+        WriteResult result = service.updateGearStatus(gear.gearId, gear.status == available ? broken : available, gear.version);
+        if(result == WriteResult::Ok){
+            ++counters->gearEditOk;
+            QMutexLocker locker(&counters->gearEditMutex);
+            ++counters->gearEditsById[gear.gearId];
+        }else if(result == WriteResult::Conflict){
+            ++counters->gearEditConflict;
+        }else{
+            ++counters->writeErrors;
+        }
+        QThread::msleep(2);
+    }
+}
+
+// 管理端站点线程：短暂下线再上线，每次都按刚读到的版本号修改
+void runStationAdmin(qint64 deadlineMs, const QElapsedTimer& clock, Counters* counters){
+    Admin_StationService service;
+    auto setOnline = [&](bool online){
+        for(const StationStats& stats : service.getStationStats()){
+            if(stats.stationId != kStationId) continue;
+            if(stats.isOnline == online) return;
+            WriteResult result = service.updateStationStatus(kStationId, online, stats.version);
+            if(result == WriteResult::Ok) ++counters->stationEditOk;
+            else if(result == WriteResult::Conflict) ++counters->stationEditConflict;
+            else ++counters->writeErrors;
+        }
+    };
+    while(clock.elapsed() < deadlineMs){
+        QThread::msleep(200);
+        setOnline(false);
+        QThread::msleep(20);
+        setOnline(true);
+    }
+    setOnline(true);
+}
+}
+
+int main(int argc, char* argv[]){
+    QCoreApplication app(argc, argv);
+    const int seconds = argc > 1 ? qMax(1, QByteArray(argv[1]).toInt()) : 5;
+
+    QTemporaryDir dir;
+    if(!dir.isValid()){
+        qCritical() << "无法创建临时目录";
+        return 1;
+    }
+    PoolConfig config;
+    config.backend = DbBackend::Sqlite;
+    config.databaseName = dir.filePath(QStringLiteral("borrow_stress.db"));
+    config.minConnections = 2;
+    config.maxConnections = 8; // 少于线程数，借连接时也会排队
+    ConnectionPool::configure(config);
+
+    MigrationReport migration = SchemaMigrator::migrate();
+    if(!migration.ok){
+        qCritical() << "迁移失败:" << migration.error;
+        return 1;
+    }
+    {
+        auto lease = ConnectionPool::acquire();
+        if(!lease || !seed(*lease)){
+            qCritical() << "初始化测试数据失败";
+            return 1;
+        }
+    }
+
+    // 压测期间关掉每次借还的 info 日志和预期内的冲突告警
+    QLoggingCategory::setFilterRules(QStringLiteral("*.info=false\n*.warning=false"));
+    Counters counters;
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 deadlineMs = seconds * 1000LL;
+    std::vector<std::unique_ptr<QThread>> threads;
+    for(int i = 0; i < kUserCount; ++i){
+        const QString userId = userIdOf(i);
+        threads.emplace_back(QThread::create([userId, deadlineMs, &clock, &counters]{ runKiosk(userId, deadlineMs, clock, &counters); }));
+    }
+    for(int i = 0; i < 2; ++i){
+        threads.emplace_back(QThread::create([deadlineMs, &clock, &counters]{ runGearAdmin(deadlineMs, clock, &counters); }));
+    }
+    threads.emplace_back(QThread::create([deadlineMs, &clock, &counters]{ runStationAdmin(deadlineMs, clock, &counters); }));
+    for(auto& thread : threads) thread->start();
+    for(auto& thread : threads) thread->wait();
+    const qint64 elapsedMs = clock.elapsed();
+    QLoggingCategory::setFilterRules(QString());
+
+    const int operations = counters.borrowOk + counters.borrowFailed + counters.returnOk + counters.returnFailed
+                         + counters.gearEditOk + counters.gearEditConflict + counters.stationEditOk + counters.stationEditConflict;
+    qInfo().noquote() << QStringLiteral("%1 ms，共 %2 次操作（%3 次/秒）")
+                         .arg(elapsedMs).arg(operations).arg(operations * 1000.0 / qMax<qint64>(1, elapsedMs), 0, 'f', 1);
+    qInfo().noquote() << QStringLiteral("借伞 成功 %1 / 失败 %2，还伞 成功 %3 / 失败 %4")
+                         .arg(counters.borrowOk.load()).arg(counters.borrowFailed.load()).arg(counters.returnOk.load()).arg(counters.returnFailed.load());
+    qInfo().noquote() << QStringLiteral("管理端改雨具 成功 %1 / 冲突 %2，改站点 成功 %3 / 冲突 %4")
+                         .arg(counters.gearEditOk.load()).arg(counters.gearEditConflict.load())
+                         .arg(counters.stationEditOk.load()).arg(counters.stationEditConflict.load());
+
+    auto lease = ConnectionPool::acquire();
+    if(!lease){
+        qCritical() << "检查阶段借不到连接";
+        return 1;
+    }
+    QSqlDatabase& db = *lease;
+
+    check(counters.writeErrors == 0, "没有数据库错误");
+    check(counters.borrowOk > 0 && counters.returnOk > 0, "借还都有成功的请求");
+
+    // 同一把雨具不会被借出两次，同一用户不会同时有两单
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM (SELECT gear_id FROM record WHERE return_time IS NULL "
+                                    "GROUP BY gear_id HAVING count(*) > 1) t")) == 0,
+          "每把雨具最多一条未归还订单");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM (SELECT user_id FROM record WHERE return_time IS NULL "
+                                    "GROUP BY user_id HAVING count(*) > 1) t")) == 0,
+          "每个用户最多一条未归还订单");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM users u WHERE coalesce(u.open_record_id, -1) <> coalesce("
+                                    "(SELECT max(r.record_id) FROM record r WHERE r.user_id = u.user_id AND r.return_time IS NULL), -1)")) == 0,
+          "users.open_record_id 与未归还订单一致");
+
+    // 雨具状态、槽位与订单一致
+    const double openRecords = scalar(db, QStringLiteral("SELECT count(*) FROM record WHERE return_time IS NULL"));
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM record r JOIN raingear g ON g.gear_id = r.gear_id "
+                                    "WHERE r.return_time IS NULL AND (g.status <> 2 OR g.slot_id IS NOT NULL)")) == 0,
+          "未归还订单对应的雨具都是借出状态且不占槽位");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM raingear WHERE status = 2")) == openRecords,
+          "借出状态的雨具数等于未归还订单数");
+    const int gearCount = static_cast<int>(std::size(kSeedSlots));
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM raingear WHERE station_id = %1 AND slot_id IS NOT NULL").arg(kStationId))
+              == gearCount - openRecords,
+          "站点占用槽位数等于雨具总数减去借出数");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM (SELECT station_id, slot_id FROM raingear WHERE slot_id IS NOT NULL "
+                                    "GROUP BY station_id, slot_id HAVING count(*) > 1) t")) == 0,
+          "每个槽位最多一把雨具");
+    bool slotTypesOk = true;
+    {
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("SELECT type_id, slot_id FROM raingear WHERE slot_id IS NOT NULL"));
+        while(query.next()){
+            slotTypesOk = slotTypesOk && StationUtils::isSlotForType(static_cast<GearType>(query.value(0).toInt()), query.value(1).toInt());
+        }
+    }
+    check(slotTypesOk, "雨具都放在对应类型的槽位");
+
+    // 订单数与成功的请求数一致，余额 + 已结算费用 + 未归还押金 = 初始余额
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM record")) == counters.borrowOk, "订单数等于借伞成功数");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM record WHERE return_time IS NOT NULL")) == counters.returnOk,
+          "已归还订单数等于还伞成功数");
+    check(scalar(db, QStringLiteral("SELECT count(*) FROM request_log")) == counters.borrowOk + counters.returnOk,
+          "每个成功的请求都记入 request_log");
+    double heldDeposits = 0.0;
+    {
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("SELECT g.gear_id, g.type_id FROM record r JOIN raingear g ON g.gear_id = r.gear_id "
+                                  "WHERE r.return_time IS NULL"));
+        while(query.next()){
+            auto gear = RainGearFactory::create_raingear(static_cast<GearType>(query.value(1).toInt()), query.value(0).toString());
+            if(gear) heldDeposits += gear->get_deposit();
+        }
+    }
+    const double credit = scalar(db, QStringLiteral("SELECT sum(credit) FROM users"));
+    const double charged = scalar(db, QStringLiteral("SELECT coalesce(sum(cost), 0) FROM record WHERE return_time IS NOT NULL"));
+    check(qAbs(credit + charged + heldDeposits - kUserCount * kInitialCredit) < 0.005, "余额、费用与押金守恒，没有丢失更新");
+
+    // 版本号：借出、归还各加一次，再加上管理端成功修改的次数
+    bool versionsOk = true;
+    {
+        QSqlQuery query(db);
+        query.exec(QStringLiteral("SELECT g.gear_id, g.version,"
+                                  " (SELECT count(*) FROM record r WHERE r.gear_id = g.gear_id),"
+                                  " (SELECT count(*) FROM record r WHERE r.gear_id = g.gear_id AND r.return_time IS NOT NULL)"
+                                  " FROM raingear g"));
+        while(query.next()){
+            const QString gearId = query.value(0).toString();
+            const int expected = query.value(2).toInt() + query.value(3).toInt() + counters.gearEditsById.value(gearId);
+            if(query.value(1).toInt() != expected){
+                qCritical() << "雨具" << gearId << "版本号" << query.value(1).toInt() << "应为" << expected;
+                versionsOk = false;
+            }
+        }
+    }
+    check(versionsOk, "雨具版本号等于成功写入次数");
+    check(scalar(db, QStringLiteral("SELECT version FROM station WHERE station_id = %1").arg(kStationId)) == counters.stationEditOk,
+          "站点版本号等于成功修改次数");
+
+    lease.release();
+    return failures == 0 ? 0 : 1;
+}
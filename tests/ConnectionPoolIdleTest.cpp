@@ -0,0 +1,74 @@
+/*
+  连接池空闲回收测试：后台探测一直在跑的情况下，超出 minConnections 的空闲连接仍要在 idleTimeoutMs 后被回收。
+  使用 SQLite 临时库文件，不依赖 MySQL。
+ */
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <vector>
+
+#include "../src/utils/ConnectionPool.h"
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const char* what){
+    if(!condition){
+        qCritical() << "[FAIL]" << what;
+        ++failures;
+    }else{
+        qInfo() << "[ OK ]" << what;
+    }
+}
+}
+
+int main(int argc, char* argv[]){
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if(!dir.isValid()){
+        qCritical() << "无法创建临时目录";
+        return 1;
+    }
+
+    PoolConfig config;
+    config.backend = DbBackend::Sqlite;
+    config.databaseName = dir.filePath(QStringLiteral("pool_idle.db"));
+    config.minConnections = 1;
+    config.maxConnections = 3;
+    config.idleTimeoutMs = 600;
+    config.validateAfterIdleMs = 100;
+    config.pingIntervalMs = 100;
+    ConnectionPool::configure(config);
+
+    // 同时借出 3 个连接，把池撑到上限后全部归还
+    {
+        std::vector<ConnectionLease> leases;
+        for(int i = 0; i < config.maxConnections; ++i) leases.push_back(ConnectionPool::acquire());
+        bool allValid = true;
+        for(const ConnectionLease& lease : leases) allValid = allValid && lease.isValid();
+        check(allValid, "借出 maxConnections 个连接");
+    }
+    check(ConnectionPool::stats().totalConnections == config.maxConnections, "归还后连接仍在池中");
+
+    // 按探测间隔持续 ping，间隔远小于 idleTimeoutMs；探测不能让连接一直显得"刚用过"
+    QElapsedTimer timer;
+    timer.start();
+    while(timer.elapsed() < config.idleTimeoutMs * 3){
+        ConnectionPool::ping();
+        QThread::msleep(config.pingIntervalMs);
+    }
+
+    PoolStats stats = ConnectionPool::stats();
+    check(stats.connectionsReclaimed == static_cast<quint64>(config.maxConnections - config.minConnections),
+          "探测期间多余的空闲连接被回收");
+    check(stats.totalConnections == config.minConnections, "回收后保留 minConnections 个连接");
+
+    // 保留下来的连接仍然可用
+    ConnectionLease lease = ConnectionPool::acquire();
+    check(lease.isValid() && lease->isOpen(), "回收后仍能借出可用连接");
+    lease.release();
+
+    return failures == 0 ? 0 : 1;
+}